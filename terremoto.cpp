@@ -29,11 +29,23 @@
  
    
  
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "core/ChTimer.h"
 #include "physics/ChSystem.h"
-#include "physics/ChBodyEasy.h"
-#include "assets/ChTexture.h"
-#include "motion_functions/ChFunction_Sine.h"
 #include "unit_IRRLICHT/ChIrrApp.h"
+#include "unit_IRRLICHT/ChIrrNodeAsset.h"
+
+#include "terremoto_model.h"
+#include "terremoto_records.h"
+#include "terremoto_run.h"
+#include "terremoto_regression.h"
+#include "terremoto_queue.h"
  
 
 
@@ -51,937 +63,538 @@ using namespace io;
 using namespace gui; 
 
 
-ChSharedPtr<ChMaterialSurface> mmat;
-
-	// Utility function. Create a tapered column as a faceted convex hull.
-	// For convex hulls, you just need to build a vector of points, it does not matter the order,
-	// because they will be considered 'wrapped' in a convex hull anyway.
- 
-ChSharedPtr<ChBody> create_column(
-		ChSystem& mphysicalSystem, 
-		ChCoordsys<> base_pos, 
-		int    col_nedges= 10,
-		double col_radius_hi= 0.45,
-		double col_radius_lo= 0.5,
-		double col_height=6,
-		double col_density= 3000)
+static void print_usage()
 {
-	
-	double col_base=0;
+	GetLog() << "Usage: \n"
+			 << "  myexe                       interactive run, with 3D view \n"
+			 << "  myexe --list   \"<query>\"    list the records of the library that match the query \n"
+			 << "  myexe --sweep  \"<query>\"    run without 3D view one case per horizontal record that \n"
+			 << "                              matches the query (paired with its vertical companion) \n"
+			 << "  myexe --compare \"<query>\"    as --sweep, but each barrier record runs side by side with \n"
+			 << "                              its no-barrier variant, with paired output \n"
+			 << "  myexe --record-golden \"<query>\"  as --sweep, but store the brick trajectories of each \n"
+			 << "                              case, run in deterministic mode, as golden trajectories \n"
+			 << "  myexe --regression \"<query>\"  as --record-golden, but compare with the golden trajectories \n"
+			 << "                              and their runtime; exits with 1 if some case fails. The golden \n"
+			 << "                              trajectories are not shipped: record them with the same build, \n"
+			 << "                              on the same platform, as the runs they check \n"
+			 << "  myexe --queue <dir> --enqueue \"<query>\"  write the cases of the sweep in a work-queue directory \n"
+			 << "  myexe --queue <dir> --work  run the cases of a work-queue directory until none is left; \n"
+			 << "                              many processes, on several machines, can drain the same queue \n"
+			 << "Options: \n"
+			 << "  --library <dir>             directory of the record library (default: data directory) \n"
+			 << "  --rebuild-index             re-ingest all records of the library \n"
+			 << "  --ampl <a1,a2,..>           amplitude factors of the sweep (default: 7) \n"
+			 << "  --complex                   use the complex temple instead of the simple one \n"
+			 << "  --no-dumps                  save only the summary records, not the full time histories \n"
+			 << "  --raw-motion                impose the records as sampled, without baseline correction, \n"
+			 << "                              filtering and resampling to the solver step (displacement \n"
+			 << "                              records only); the preprocessing is on by default, so results \n"
+			 << "                              differ from those of the raw motion of earlier versions \n"
+			 << "  --deterministic             single-threaded run, without sleeping bodies: identical output \n"
+			 << "                              across runs of one build on one platform (the order of the \n"
+			 << "                              contacts is Chrono's, so other builds may differ) \n"
+			 << "  --log-every <n>             write the full dumps every n steps (default: 1) \n"
+			 << "  --trigger-impulse <N s>     capture at full rate around the steps where the normal impulse \n"
+			 << "                              of a body interface changes more than this \n"
+			 << "  --trigger-acc <m/s2>        ... where a brick accelerates, relative to the table, more than this \n"
+			 << "  --trigger-tilt-rate <rad/s> ... where a drum tilts faster than this \n"
+			 << "  --capture <before,after>    seconds captured before and after a trigger (default: 0.25,0.5); \n"
+			 << "                              the captures go to capture_*.dat, the events to events.dat \n"
+			 << "  --material-pair \"<m> <m> f c d\"  friction, compliance and damping of the contacts between two \n"
+			 << "                              materials (concrete, table, marble, brick), ex. \"marble brick 0.5 4e-8 1.5\"; \n"
+			 << "                              may be repeated (default: the surfaces combined) \n"
+			 << "  --multi <file>              in the interactive run and in the cases, impose all the components \n"
+			 << "                              of a combined record, with lines  t x y z [rx ry rz]  (y vertical, \n"
+			 << "                              rotations in rad), instead of the horizontal and vertical records; \n"
+			 << "                              x and the rotations are dumped to data_earthquake_{t,rx,ry,rz}.dat \n"
+			 << "  --stream-h <pipe>           in the interactive run only, read the horizontal motion as \n"
+			 << "                              time/value lines from a pipe or FIFO (\"-\" for the standard \n"
+			 << "                              input) while the simulation runs, instead of a record; a stream \n"
+			 << "                              is read once, so it cannot drive the cases of a sweep or queue \n"
+			 << "  --stream-v <pipe>           as --stream-h, for the vertical motion (default: none) \n"
+			 << "  --stream-window <n>         samples of each stream kept in memory (default: 4096) \n"
+			 << "  --t-end <s>                 end time of the simulation \n"
+			 << "  --golden-dir <dir>          directory of the golden trajectories (default: golden) \n"
+			 << "  --tolerance <m>             max displacement error in regression checks (default: 1e-6) \n"
+			 << "  --status <file>             in sweeps and comparisons, rewrite this status file every few \n"
+			 << "                              seconds with the progress of the batch \n"
+			 << "  --lease <s>                 claims of the work queue not renewed for this long expire (default: 300) \n"
+			 << "  --shadows all|none|deferred  shadow casting in the 3D view; deferred adds the shadows \n"
+			 << "                              after the first frame (default: all) \n"
+			 << "  --asset-batch <n>           convert the visual assets of n bodies per frame, instead of \n"
+			 << "                              all before the first frame (default: 0, all) \n"
+			 << "  --runtime-tolerance <r>     max runtime / golden runtime in regression checks (default: 1.5) \n"
+			 << "Queries are like  \"barrier=0 quantity=U pga>2\" , keys: name set barrier quantity direction dt duration pga peak \n";
+}
 
-	std::vector< ChVector<> > mpoints;
-	for (int i=0; i< col_nedges; ++i)
-	{
-		double alpha = CH_C_2PI * ((double)i/(double)col_nedges); // polar coord
-		double x = col_radius_hi * cos(alpha);
-		double z = col_radius_hi * sin(alpha);
-		double y = col_base + col_height;
-		mpoints.push_back( ChVector<> (x,y,z) );
-	}
-	for (int i=0; i< col_nedges; ++i)
+static std::vector<double> parse_list(const char* text)
+{
+	std::vector<double> values;
+	const char* p = text;
+	char* end;
+	while (*p)
 	{
-		double alpha = CH_C_2PI * ((double)i/(double)col_nedges); // polar coord
-		double x = col_radius_lo * cos(alpha);
-		double z = col_radius_lo * sin(alpha);
-		double y = col_base;
-		mpoints.push_back( ChVector<> (x,y,z) );
+		double v = strtod(p, &end);
+		if (end == p)
+			break;
+		values.push_back(v);
+		p = end;
+		if (*p == ',')
+			++p;
 	}
-	ChSharedPtr<ChBodyEasyConvexHull> bodyColumn(new ChBodyEasyConvexHull(
-							mpoints, 
-							col_density, 
-							true, 
-							true));
-	ChCoordsys<> cog_column(ChVector<>(0, col_base+col_height/2, 0));
-	ChCoordsys<> abs_cog_column = cog_column >> base_pos;
-	bodyColumn->SetCoord( abs_cog_column );
-	
-
-	//create a texture for the column
-	ChSharedPtr<ChTexture> mtexturecolumns(new ChTexture());
-	mtexturecolumns->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-	bodyColumn->AddAsset(mtexturecolumns);
-
-	bodyColumn->SetMaterialSurface(mmat);
-
-	mphysicalSystem.Add(bodyColumn);
-
-	return bodyColumn;
+	return values;
 }
 
-ChSharedPtr<ChBody> create_brickcolumn(
-	ChSystem& mphysicalSystem,
-	ChCoordsys<> base_pos,
-	int    col_nedges = 10,
-	double col_radius_hi = 0.45,
-	double col_radius_lo = 0.5,
-	double col_height = 6,
-	double col_density = 3000)
+// The case of a sweep for a horizontal record: the vertical component is
+// its companion record, if any.
+
+static RunCase make_sweep_case(const RunCase& base, const RecordLibrary& library, const RecordInfo& record_h, double ampl_factor)
 {
+	const RecordInfo* companion = library.FindCompanion(record_h);
+	RunCase scase = base;
+	scase.record_set  = record_h.set;
+	scase.record_h    = record_h.name;
+	scase.record_v    = companion ? companion->name : "";
+	scase.ampl_factor = ampl_factor;
+	char label[300];
+	sprintf(label, "%s_ampl%g%s", scase.record_h.c_str(), scase.ampl_factor, scase.simple_temple ? "" : "_complex");
+	scase.label = label;
+	return scase;
+}
 
-	double col_base = 0;
 
-	std::vector< ChVector<> > mpoints;
-	for (int i = 0; i< col_nedges; ++i)
-	{
-		double alpha = CH_C_2PI * ((double)i / (double)col_nedges); // polar coord
-		double x = col_radius_hi * cos(alpha);
-		double z = col_radius_hi * sin(alpha);
-		double y = col_base + col_height;
-		mpoints.push_back(ChVector<>(x, y, z));
-	}
-	for (int i = 0; i< col_nedges; ++i)
+// The first mesh node under an Irrlicht node, or 0.
+
+static ISceneNode* find_mesh_node(ISceneNode* node)
+{
+	const core::list<ISceneNode*>& children = node->getChildren();
+	for (core::list<ISceneNode*>::ConstIterator child = children.begin(); child != children.end(); ++child)
 	{
-		double alpha = CH_C_2PI * ((double)i / (double)col_nedges); // polar coord
-		double x = col_radius_lo * cos(alpha);
-		double z = col_radius_lo * sin(alpha);
-		double y = col_base;
-		mpoints.push_back(ChVector<>(x, y, z));
+		if ((*child)->getType() == ESNT_MESH)
+			return *child;
+		ISceneNode* found = find_mesh_node(*child);
+		if (found)
+			return found;
 	}
-	ChSharedPtr<ChBodyEasyConvexHull> bodyColumn(new ChBodyEasyConvexHull(
-		mpoints,
-		col_density,
-		true,
-		true));
-	ChCoordsys<> cog_column(ChVector<>(0, col_base + col_height / 2, 0));
-	ChCoordsys<> abs_cog_column = cog_column >> base_pos;
-	bodyColumn->SetCoord(abs_cog_column);
-	mphysicalSystem.Add(bodyColumn);
+	return 0;
+}
 
-	//create a texture for the brickcolumn
-	ChSharedPtr<ChTexture> mtexturecolumns(new ChTexture());
-	mtexturecolumns->SetTextureFilename(GetChronoDataFile("orange.png"));
-	bodyColumn->AddAsset(mtexturecolumns);
+// The Irrlicht node of a body, once its assets are bound, or 0.
 
-	bodyColumn->SetMaterialSurface(mmat);
+static ISceneNode* find_body_node(ChBody* body)
+{
+	std::vector< ChSharedPtr<ChAsset> >& assets = body->GetAssets();
+	for (size_t i = 0; i < assets.size(); ++i)
+		if (assets[i].IsType<ChIrrNodeAsset>())
+			return assets[i].DynamicCastTo<ChIrrNodeAsset>()->GetIrrlichtNode();
+	return 0;
+}
 
-	return bodyColumn;
+// A column chunk with the shape of an earlier one has no mesh asset: the
+// mesh node of the first chunk is cloned under its node, so that Irrlicht
+// keeps one mesh per shape. Called once the assets of both are converted.
 
+static void attach_shared_mesh(ChIrrApp& application, const TempleModel& model, ChBody* body)
+{
+	std::map<ChBody*, ChBody*>::const_iterator source = model.hull_instances.find(body);
+	if (source == model.hull_instances.end())
+		return;
+	ISceneNode* node = find_body_node(body);
+	ISceneNode* source_node = find_body_node(source->second);
+	ISceneNode* mesh_node = source_node ? find_mesh_node(source_node) : 0;
+	if (!node || !mesh_node)
+		return;
+	ISceneNode* instance = mesh_node->clone(node, application.GetSceneManager());
+
+	// the texture of this chunk, not of the first one
+	std::vector< ChSharedPtr<ChAsset> >& assets = body->GetAssets();
+	for (size_t i = 0; i < assets.size(); ++i)
+		if (assets[i].IsType<ChTexture>())
+			instance->setMaterialTexture(0, application.GetVideoDriver()->getTexture(assets[i].DynamicCastTo<ChTexture>()->GetTextureFilename().c_str()));
 }
-   
- 
-ChFunction* create_motion(std::string filename_pos, double t_offset = 0, double factor =1.0)
+
+
+int main(int argc, char* argv[])
 {
-	ChStreamInAsciiFile mstream(GetChronoDataFile(filename_pos).c_str());
-	
-	ChFunction_Recorder* mrecorder = new ChFunction_Recorder;
-	
-	while(!mstream.End_of_stream())
+	// Startup time, up to the first frame of the interactive run
+	ChTimer<double> startup_timer;
+	startup_timer.start();
+
+	// Parse the command line
+
+	std::string library_dir = GetChronoDataFile("");
+	std::string list_query;
+	std::string sweep_query;
+	std::string compare_query;
+	std::string golden_query;
+	std::string regression_query;
+	bool rebuild_index = false;
+	bool list_mode = false;
+	bool sweep_mode = false;
+	bool compare_mode = false;
+	bool golden_mode = false;
+	bool regression_mode = false;
+	RegressionSettings regression;
+	std::string status_filename;
+	std::string queue_dir;
+	std::string enqueue_query;
+	bool enqueue_mode = false;
+	bool work_mode = false;
+	double lease = 300;
+	std::string shadows = "all";
+	int asset_batch = 0;
+	std::vector<double> sweep_ampl(1, 7.0);
+	RunCase mcase;
+
+	for (int i = 1; i < argc; ++i)
 	{
-		double time = 0;
-		double value = 0;
-		try
+		if      (!strcmp(argv[i], "--library") && i + 1 < argc) library_dir = argv[++i];
+		else if (!strcmp(argv[i], "--list")    && i + 1 < argc) { list_mode = true;  list_query  = argv[++i]; }
+		else if (!strcmp(argv[i], "--sweep")   && i + 1 < argc) { sweep_mode = true; sweep_query = argv[++i]; }
+		else if (!strcmp(argv[i], "--compare") && i + 1 < argc) { compare_mode = true; compare_query = argv[++i]; }
+		else if (!strcmp(argv[i], "--record-golden") && i + 1 < argc) { golden_mode = true; golden_query = argv[++i]; }
+		else if (!strcmp(argv[i], "--regression")    && i + 1 < argc) { regression_mode = true; regression_query = argv[++i]; }
+		else if (!strcmp(argv[i], "--ampl")    && i + 1 < argc) sweep_ampl = parse_list(argv[++i]);
+		else if (!strcmp(argv[i], "--golden-dir") && i + 1 < argc) regression.golden_dir = argv[++i];
+		else if (!strcmp(argv[i], "--tolerance")  && i + 1 < argc) regression.tolerance = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--runtime-tolerance") && i + 1 < argc) regression.runtime_tolerance = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--rebuild-index")) rebuild_index = true;
+		else if (!strcmp(argv[i], "--complex"))  mcase.simple_temple = false;
+		else if (!strcmp(argv[i], "--no-dumps")) mcase.save_full_dumps = false;
+		else if (!strcmp(argv[i], "--raw-motion")) mcase.preprocessing.enabled = false;
+		else if (!strcmp(argv[i], "--deterministic")) mcase.deterministic = true;
+		else if (!strcmp(argv[i], "--log-every") && i + 1 < argc) mcase.capture.decimation = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--trigger-impulse") && i + 1 < argc) mcase.capture.contact_impulse = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--trigger-acc") && i + 1 < argc) mcase.capture.rel_acc = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--trigger-tilt-rate") && i + 1 < argc) mcase.capture.tilt_rate = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--capture") && i + 1 < argc)
 		{
-			mstream >> time;
-			mstream >> value;
-
-			GetLog() << "  t=" << time << "  p=" << value << "\n";
-
-			mrecorder->AddPoint(time + t_offset, value * factor);
+			std::vector<double> window = parse_list(argv[++i]);
+			if (window.size() != 2)
+			{
+				print_usage();
+				return 1;
+			}
+			mcase.capture.t_before = window[0];
+			mcase.capture.t_after  = window[1];
 		}
-		catch(ChException myerror)
+		else if (!strcmp(argv[i], "--material-pair") && i + 1 < argc)
 		{
-			GetLog() << "  End parsing file " << GetChronoDataFile(filename_pos).c_str() << " because: \n  " << myerror.what() << "\n";
-			break;
+			MaterialPair pair;
+			if (!parse_material_pair(argv[++i], pair))
+			{
+				print_usage();
+				return 1;
+			}
+			mcase.material_pairs.push_back(pair);
+		}
+		else if (!strcmp(argv[i], "--multi") && i + 1 < argc) mcase.record_multi = argv[++i];
+		else if (!strcmp(argv[i], "--stream-h") && i + 1 < argc) mcase.stream_h = argv[++i];
+		else if (!strcmp(argv[i], "--stream-v") && i + 1 < argc) mcase.stream_v = argv[++i];
+		else if (!strcmp(argv[i], "--stream-window") && i + 1 < argc) mcase.stream_window = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--t-end") && i + 1 < argc) mcase.t_end = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--status") && i + 1 < argc) status_filename = argv[++i];
+		else if (!strcmp(argv[i], "--queue")   && i + 1 < argc) queue_dir = argv[++i];
+		else if (!strcmp(argv[i], "--enqueue") && i + 1 < argc) { enqueue_mode = true; enqueue_query = argv[++i]; }
+		else if (!strcmp(argv[i], "--work"))   work_mode = true;
+		else if (!strcmp(argv[i], "--lease")   && i + 1 < argc) lease = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--shadows") && i + 1 < argc) shadows = argv[++i];
+		else if (!strcmp(argv[i], "--asset-batch") && i + 1 < argc) asset_batch = atoi(argv[++i]);
+		else
+		{
+			print_usage();
+			return 1;
 		}
 	}
-	GetLog() << "Done parsing. \n";
 
-	return mrecorder;
-}
+	// Open the library of ground-motion records (this ingests new records, if any)
 
+	RecordLibrary library;
+	library.Open(library_dir);
+	if (rebuild_index)
+		library.Rebuild();
 
-int main(int argc, char* argv[])
-{
-	// Create a ChronoENGINE physical system
-	ChSystem mphysicalSystem;
-
-	// Create the Irrlicht visualization (open the Irrlicht device, 
-	// bind a simple user interface, etc. etc.)
-	ChIrrApp application(&mphysicalSystem, L"Collisions between objects",core::dimension2d<u32>(800,600),false); //screen dimensions
-
-	// Easy shortcuts to add camera, lights, logo and sky in Irrlicht scene:
-	application.AddTypicalLogo();
-	application.AddTypicalSky();
-	application.AddTypicalLights();
-	application.AddTypicalCamera(core::vector3df(1,1,-5), core::vector3df(3,3,0));		//to change the position of camera
-	application.AddLightWithShadow(vector3df(1,25,-5), vector3df(0,0,0), 35, 0.2,35, 55, 512, video::SColorf(1,1,1));
- 
-	// Create a shared material surface used by columns etc.
-	mmat = ChSharedPtr<ChMaterialSurface>(new ChMaterialSurface);
-	mmat->SetFriction(0.6);
-	//mmat->SetSpinningFriction(0.01);
-	//mmat->SetRollingFriction(0.01);
-	mmat->SetCompliance(0.00000002);
-	mmat->SetDampingF(1.5);
-
-	// Create all the rigid bodies.
-
-	// Create a floor that is fixed (that is used also to represent the aboslute reference)
-
-	ChSharedPtr<ChBodyEasyBox> floorBody(new ChBodyEasyBox( 20,2,20,  3000,	false, true));		//to create the floor, false -> doesn't represent a collide's surface
-	floorBody->SetPos( ChVector<>(0,-2,0) );
-	floorBody->SetBodyFixed(true);		//SetBodyFixed(true) -> it's fixed, it doesn't move respect to the Global Position System
-
-	mphysicalSystem.Add(floorBody);
-
-	// optional, attach a texture for better visualization
-	ChSharedPtr<ChTexture> mtexture(new ChTexture());
-    mtexture->SetTextureFilename(GetChronoDataFile("blu.png"));		//texture in /data
-	floorBody->AddAsset(mtexture);		//add texture to the system
+	if (list_mode)
+	{
+		std::vector<const RecordInfo*> selection = library.Select(list_query);
+		for (unsigned int i = 0; i < selection.size(); ++i)
+		{
+			const RecordInfo* r = selection[i];
+			GetLog() << r->name.c_str() << "  [" << r->set.c_str() << "]  barrier=" << (int)r->barrier
+					 << " dt=" << r->dt << " duration=" << r->duration << " pga=" << r->pga << "\n";
+		}
+		return 0;
+	}
 
+	if (sweep_mode)
+	{
+		// One case per horizontal record and amplitude; the vertical
+		// component is the companion record, if any.
+		std::vector<const RecordInfo*> selection = library.Select(sweep_query + " direction=h");
+		Telemetry* telemetry = status_filename.empty() ? 0 : new Telemetry(status_filename);
+		if (telemetry)
+			telemetry->SetCasesTotal((int)(selection.size() * sweep_ampl.size()));
+		for (unsigned int i = 0; i < selection.size(); ++i)
+			for (unsigned int j = 0; j < sweep_ampl.size(); ++j)
+			{
+				bool ok = run_case(make_sweep_case(mcase, library, *selection[i], sweep_ampl[j]), library, telemetry ? &telemetry->GetWorker(0) : 0);
+				if (telemetry)
+					telemetry->CaseDone(ok);
+			}
+		delete telemetry;
+		return 0;
+	}
 
+	if (compare_mode)
+	{
+		// As the sweep, but for barrier records only, each one paired
+		// with its no-barrier variant.
+		std::vector<const RecordInfo*> selection = library.Select(compare_query + " direction=h barrier=1");
+		Telemetry* telemetry = status_filename.empty() ? 0 : new Telemetry(status_filename);
+		if (telemetry)
+			telemetry->SetCasesTotal((int)(selection.size() * sweep_ampl.size()));
+		for (unsigned int i = 0; i < selection.size(); ++i)
+		{
+			const RecordInfo* variant = library.FindVariant(*selection[i]);
+			if (!variant)
+			{
+				GetLog() << "No no-barrier variant for " << selection[i]->name.c_str() << "\n";
+				for (unsigned int j = 0; telemetry && j < sweep_ampl.size(); ++j)
+					telemetry->CaseDone(false);
+				continue;
+			}
+			for (unsigned int j = 0; j < sweep_ampl.size(); ++j)
+			{
+				bool ok = run_comparison(make_sweep_case(mcase, library, *selection[i], sweep_ampl[j]),
+										 make_sweep_case(mcase, library, *variant, sweep_ampl[j]),
+										 library, telemetry ? &telemetry->GetWorker(0) : 0);
+				if (telemetry)
+					telemetry->CaseDone(ok);
+			}
+		}
+		delete telemetry;
+		return 0;
+	}
 
-	// Create the table that is subject to earthquake
+	if ((enqueue_mode || work_mode) && queue_dir.empty())
+	{
+		print_usage();
+		return 1;
+	}
 
-	ChSharedPtr<ChBodyEasyBox> tableBody(new ChBodyEasyBox( 17,1,15,  3000,	true, true));
-	tableBody->SetPos( ChVector<>(4.05,-0.5,0) );
+	// A stream is consumed by the case that reads it: the next case would
+	// get what the first left behind.
+	bool batch_mode = sweep_mode || compare_mode || golden_mode || regression_mode || enqueue_mode || work_mode;
+	if (batch_mode && (!mcase.stream_h.empty() || !mcase.stream_v.empty()))
+	{
+		GetLog() << "--stream-h and --stream-v apply to the interactive run only \n";
+		return 1;
+	}
 
-	mphysicalSystem.Add(tableBody);
+	if (enqueue_mode)
+	{
+		// The cases of the sweep, to be run later by the workers
+		WorkQueue queue(queue_dir, lease);
+		std::vector<const RecordInfo*> selection = library.Select(enqueue_query + " direction=h");
+		int nqueued = 0;
+		for (unsigned int i = 0; i < selection.size(); ++i)
+			for (unsigned int j = 0; j < sweep_ampl.size(); ++j)
+				if (queue.Enqueue(make_sweep_case(mcase, library, *selection[i], sweep_ampl[j])))
+					++nqueued;
+		GetLog() << nqueued << " cases queued in " << queue_dir.c_str() << "\n";
+		return 0;
+	}
 
-	// optional, attach a texture for better visualization
-	ChSharedPtr<ChTexture> mtextureconcrete(new ChTexture());
-    mtextureconcrete->SetTextureFilename(GetChronoDataFile("grass.png"));
-	tableBody->AddAsset(mtextureconcrete);
+	if (work_mode)
+	{
+		WorkQueue queue(queue_dir, lease);
+		Telemetry* telemetry = status_filename.empty() ? 0 : new Telemetry(status_filename);
+		int nfailed = run_queue(queue, library, telemetry);
+		delete telemetry;
+		return (nfailed > 0) ? 1 : 0;
+	}
 
+	if (golden_mode || regression_mode)
+	{
+		// As the sweep, with the cases checked against (or stored as)
+		// golden trajectories.
+		std::vector<const RecordInfo*> selection = library.Select((golden_mode ? golden_query : regression_query) + " direction=h");
+		std::vector<RegressionResult> results;
+		bool ok = true;
+		for (unsigned int i = 0; i < selection.size(); ++i)
+			for (unsigned int j = 0; j < sweep_ampl.size(); ++j)
+			{
+				RunCase rcase = make_sweep_case(mcase, library, *selection[i], sweep_ampl[j]);
+				if (golden_mode)
+				{
+					ok = record_golden(rcase, library, regression) && ok;
+					continue;
+				}
+				RegressionResult result;
+				ok = check_regression(rcase, library, regression, result) && ok;
+				results.push_back(result);
+			}
+		if (regression_mode && report_regression(results, regression) > 0)
+			ok = false;
+		return ok ? 0 : 1;
+	}
 
-	// Create the constraint between ground and table. If no earthquake, it just
-	// keeps the table in position.
 
-	ChSharedPtr<ChLinkLockLock> linkEarthquake(new ChLinkLockLock);
-	linkEarthquake->Initialize(tableBody, floorBody, ChCoordsys<>(ChVector<>(0,0,0)) );
+	// Interactive run.
 
 	double time_offset = 5.0; // begin earthquake after 5 s to allow stabilization of blocks after creation.
 	double ampl_factor = 7; // use lower or greater to scale the earthquake.
-	bool   use_barrier = false; // if true, the Barrier data files are used, otherwise the No_Barrier datafiles are used
-
-	// Define the horizontal motion, on x:
-	//ChFunction_Sine* mmotion_x = new ChFunction_Sine(0,1.6,0.5); // phase freq ampl, carachteristics of input motion
-	ChFunction* mmotion_x    = create_motion("Time history 10x0.50 Foam (d=6 m)/Barrier_Uh.txt", time_offset, ampl_factor);
-	ChFunction* mmotion_x_NB = create_motion("Time history 10x0.50 Foam (d=6 m)/No_Barrier_Uh.txt", time_offset, ampl_factor);
+	bool   use_barrier = false; // if true, the Barrier records are used, otherwise the No_Barrier records are used
 
-	// Define the vertical motion, on y:
-	ChFunction* mmotion_y    = create_motion("Time history 10x0.50 Foam (d=6 m)/Barrier_Uv.txt", time_offset, ampl_factor);
-	ChFunction* mmotion_y_NB = create_motion("Time history 10x0.50 Foam (d=6 m)/No_Barrier_Uv.txt", time_offset, ampl_factor);
-
-	if (use_barrier)
+	if (!mcase.stream_h.empty() || !mcase.record_multi.empty())
 	{
-		linkEarthquake->SetMotion_Z(mmotion_x);
-		linkEarthquake->SetMotion_Y(mmotion_y);
+		// Streamed motion or combined record: no records (and no recorded
+		// vertical component, unless streamed too)
+		mcase.record_h = "";
+		mcase.record_v = "";
 	}
 	else
 	{
-		linkEarthquake->SetMotion_Z(mmotion_x_NB);
-		linkEarthquake->SetMotion_Y(mmotion_y_NB);
-	}
-
-	mphysicalSystem.Add(linkEarthquake);
-
-
-	// Pointers to some objects that will be plotted, for future use.
-	ChSharedPtr<ChBody> plot_brick_1;
-	ChSharedPtr<ChBody> plot_brick_2;
-	ChSharedPtr<ChBody> plot_table;
-
-	plot_table = tableBody; // others will be hooked later.
-
-
-	// Create the elements of the model
-
-
-
-	if (true)		//if it's typed "true", the simple temple will be generated
-	{
-
-		double spacing = 2.2;
-		double density = 3000;
-		int nedges=10;
-
-		//to create pedestals
-
-		//create pedestal1
-
-		ChSharedPtr<ChBodyEasyBox> pedestal1(new ChBodyEasyBox(
-			0.7, 0.1, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_pedestal1(ChVector<>(0, 0, 0));
-		pedestal1->SetCoord(cog_pedestal1);
-
-		mphysicalSystem.Add(pedestal1);
-
-		//create a texture for the pedestal1
-		ChSharedPtr<ChTexture> mtexturepedestal1(new ChTexture());
-		mtexturepedestal1->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		pedestal1->AddAsset(mtexturepedestal1);
-
-
-		//create pedestal2
-
-		ChSharedPtr<ChBodyEasyBox> pedestal2(new ChBodyEasyBox(
-			0.7, 0.1, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_pedestal2(ChVector<>(spacing, 0, 0));
-		pedestal2->SetCoord(cog_pedestal2);
-
-		mphysicalSystem.Add(pedestal2);
-
-		//create a texture for the pedestal2
-		ChSharedPtr<ChTexture> mtexturepedestal2(new ChTexture());
-		mtexturepedestal2->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		pedestal2->AddAsset(mtexturepedestal2);
-
-
-		//create pedestal3
-
-		ChSharedPtr<ChBodyEasyBox> pedestal3(new ChBodyEasyBox(
-			0.7, 0.1, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_pedestal3(ChVector<>(spacing * 2, 0, 0));
-		pedestal3->SetCoord(cog_pedestal3);
-
-		mphysicalSystem.Add(pedestal3);
-
-		//create a texture for the pedestal3
-		ChSharedPtr<ChTexture> mtexturepedestal3(new ChTexture());
-		mtexturepedestal3->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		pedestal3->AddAsset(mtexturepedestal2);
-
-
-
-		//to create columns
-
-		//create column1
-
-		ChCoordsys<> base_position1l(ChVector<>(0 * spacing, 0.1, 0));	//coordinate of the first group of columns, bottom
-		create_column(mphysicalSystem, base_position1l, nedges, 0.283, 0.30, 0.95, density);
-
-		ChCoordsys<> base_position1m(ChVector<>(0 * spacing, 1.05, 0));
-		create_brickcolumn(mphysicalSystem, base_position1m, nedges, 0.251, 0.283, 1.9, density);		//coordinate of the first group of columns, middle
-
-		ChCoordsys<> base_position1h(ChVector<>(0 * spacing, 2.95, 0));
-		plot_brick_1 = create_column(mphysicalSystem, base_position1h, nedges, 0.25, 0.251, 0.30, density);		//coordinate of the first group of columns, top
-		// NOTE!!!!! the "plot_brick_1" points to this created column chunk, and plot_brick_1 is the one that will be plotted!!
-
-		//create column2
-
-		ChCoordsys<> base_position2l(ChVector<>(1 * spacing, 0.1, 0));	//coordinate of the second group of columns, bottom
-		create_column(mphysicalSystem, base_position2l, nedges, 0.293, 0.30, 0.32, density);
-
-		ChCoordsys<> base_position2m(ChVector<>(1 * spacing, 0.42, 0));
-		create_brickcolumn(mphysicalSystem, base_position2m, nedges, 0.266, 0.293, 1.66, density);		//coordinate of the second group of columns, middle
-
-		ChCoordsys<> base_position2h(ChVector<>(1 * spacing, 2.08, 0));
-		create_column(mphysicalSystem, base_position2h, nedges, 0.25, 0.266, 1.17, density);		//coordinate of the second group of columns, top
-
-
-		//create column3
-
-		ChCoordsys<> base_position3l(ChVector<>(2 * spacing, 0.1, 0));	//coordinate of the third group of columns, bottom
-		create_column(mphysicalSystem, base_position3l, nedges, 0.285, 0.30, 1.35, density);
-
-		ChCoordsys<> base_position3m(ChVector<>(2 * spacing, 1.45, 0));
-		create_brickcolumn(mphysicalSystem, base_position3m, nedges, 0.251, 0.285, 1.55, density);		//coordinate of the third group of columns, middle
-
-		ChCoordsys<> base_position3h(ChVector<>(2 * spacing, 3, 0));
-		create_column(mphysicalSystem, base_position3h, nedges, 0.25, 0.251, 0.25, density);		//coordinate of the third group of columns, top
-
-
-
-		//to create capitals
-
-		//create capital1
-
-		ChSharedPtr<ChBodyEasyBox> capital1(new ChBodyEasyBox(
-			0.7, 0.25, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capital1(ChVector<>(0, 3.375, 0));
-		capital1->SetCoord(cog_capital1);
-
-		mphysicalSystem.Add(capital1);
-
-		//create a texture for the capital1
-		ChSharedPtr<ChTexture> mtexturecapital1(new ChTexture());
-		mtexturecapital1->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capital1->AddAsset(mtexturecapital1);
-
-
-		//create capital2
-
-		ChSharedPtr<ChBodyEasyBox> capital2(new ChBodyEasyBox(
-			0.7, 0.25, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capital2(ChVector<>(spacing, 3.375, 0));
-		capital2->SetCoord(cog_capital2);
-
-		mphysicalSystem.Add(capital2);
-
-		//create a texture for the capital2
-		ChSharedPtr<ChTexture> mtexturecapital2(new ChTexture());
-		mtexturecapital2->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capital2->AddAsset(mtexturecapital2);
-
-
-		//create capital3
-
-		ChSharedPtr<ChBodyEasyBox> capital3(new ChBodyEasyBox(
-			0.7, 0.25, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capital3(ChVector<>(2 * spacing, 3.375, 0));
-		capital3->SetCoord(cog_capital3);
-
-		mphysicalSystem.Add(capital3);
-
-		//create a texture for the capital3
-		ChSharedPtr<ChTexture> mtexturecapital3(new ChTexture());
-		mtexturecapital3->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capital3->AddAsset(mtexturecapital3);
-
-
-		//to create top beam
-
-
-		ChSharedPtr<ChBodyEasyBox> topBeam(new ChBodyEasyBox(
-			5.8, 0.75, 0.6, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_topBeam(ChVector<>(2.25, 3.875, 0));
-		topBeam->SetCoord(cog_topBeam);
-		plot_brick_2 = topBeam;
-
-		mphysicalSystem.Add(topBeam);
-
-		//create a texture for the topBeam
-		ChSharedPtr<ChTexture> mtexturetopBeam(new ChTexture());
-		mtexturetopBeam->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		topBeam->AddAsset(mtexturetopBeam);
-
-
-		/*for (int icol = 0; icol <3; ++icol)
-		{
-
-
-		if (icol< 2)
+		// Pick the displacement records from the library
+		std::vector<const RecordInfo*> records_h = library.Select(use_barrier ? "barrier=1 quantity=U direction=h" : "barrier=0 quantity=U direction=h");
+		if (records_h.empty())
 		{
-		ChSharedPtr<ChBodyEasyBox> bodyTop(new ChBodyEasyBox(
-		spacing, 0.4, 0.6, // x y z sizes
-		density,
-		true,
-		true));
-
-		ChCoordsys<> cog_top(ChVector<>(icol * spacing + spacing/2, 3 + 0.4/2, 0));
-		bodyTop->SetCoord( cog_top );
-
-		mphysicalSystem.Add(bodyTop);
-
-		//create a texture for the bodyTop
-		ChSharedPtr<ChTexture> mtextureebodyTop(new ChTexture());
-		mtextureebodyTop->SetTextureFilename(GetChronoDataFile("oldconcrete.jpg"));
-		bodyTop->AddAsset(mtextureebodyTop);
+			GetLog() << "No records in the library " << library_dir.c_str() << "\n";
+			return 1;
 		}
+		const RecordInfo* record_v = library.FindCompanion(*records_h[0]);
 
-		if (icol< 2)
-		{
-		ChSharedPtr<ChBodyEasyBox> bodyTop(new ChBodyEasyBox(
-		spacing, 1.4, 0.6, // x y z sizes
-		density,
-		true,
-		true));
+		mcase.record_set  = records_h[0]->set;
+		mcase.record_h    = records_h[0]->name;
+		mcase.record_v    = record_v ? record_v->name : "";
+	}
+	mcase.time_offset = time_offset;
+	mcase.ampl_factor = ampl_factor;
 
-		ChCoordsys<> cog_top(ChVector<>(icol * spacing + spacing / 2, 6 + 1.4 / 2, 4));
-		bodyTop->SetCoord(cog_top);
+	// Heap memory of the simulation, declared first so that it outlives the system
+	MemoryAccount memory(mcase.label.empty() ? std::string("interactive") : mcase.label);
 
-		mphysicalSystem.Add(bodyTop);
+	// Create a ChronoENGINE physical system
+	ChSystem mphysicalSystem;
 
-		//create a texture for the bodyTop
-		ChSharedPtr<ChTexture> mtexturebodyTop(new ChTexture());
-		mtexturebodyTop->SetTextureFilename(GetChronoDataFile("brick.jpg"));
-		bodyTop->AddAsset(mtexturebodyTop);
-		}
-		}*/
+	// Create the Irrlicht visualization (open the Irrlicht device, 
+	// bind a simple user interface, etc. etc.)
+	ChIrrApp application(&mphysicalSystem, L"Collisions between objects",core::dimension2d<u32>(800,600),false); //screen dimensions
 
+	// Easy shortcuts to add camera, lights, logo and sky in Irrlicht scene:
+	application.AddTypicalLogo();
+	application.AddTypicalSky();
+	application.AddTypicalLights();
+	application.AddTypicalCamera(core::vector3df(1,1,-5), core::vector3df(3,3,0));		//to change the position of camera
+	application.AddLightWithShadow(vector3df(1,25,-5), vector3df(0,0,0), 35, 0.2,35, 55, 512, video::SColorf(1,1,1));
+ 
+	// Create all the rigid bodies of the model, and impose the earthquake to the table
+	ChTimer<double> construction_timer;
+	construction_timer.start();
+	TempleModel model;
+	if (!setup_case(mphysicalSystem, model, mcase, library, &memory))
+		return 1;
+	construction_timer.stop();
+
+	ChTimer<double> conversion_timer;
+	conversion_timer.start();
+
+	// Bodies whose visual assets are converted later, a batch per frame (in
+	// creation order, so floor and table come first)
+	std::vector< ChSharedPtr<ChBody> > pending_assets;
+
+	if (asset_batch <= 0)
+	{
+		// Use this function for adding a ChIrrNodeAsset to all items
+		// Otherwise use application.AssetBind(myitem); on a per-item basis.
+		application.AssetBindAll();
+
+		// Use this function for 'converting' assets into Irrlicht meshes 
+		application.AssetUpdateAll();
+		for (std::map<ChBody*, ChBody*>::const_iterator instance = model.hull_instances.begin(); instance != model.hull_instances.end(); ++instance)
+			attach_shared_mesh(application, model, instance->first);
+
+		// This is to enable shadow maps (shadow casting with soft shadows) in Irrlicht
+		// for all objects (or use application.AddShadow(..) for enable shadow on a per-item basis)
+		if (shadows == "all")
+			application.AddShadowAll();
 	}
-
-
-	//if it's typed "false", the complex temple will be generated
-
 	else
-	
 	{
-		double spacing = 2.7;
-		double density = 3000;
-		int nedges=10;
-
-	//to create "big" columns
-
-		//create column1
-
-		ChCoordsys<> base_position1l(ChVector<>(0 * spacing, 0, 0));	//coordinate of the first group of columns, bottom
-		create_column(mphysicalSystem, base_position1l, nedges, 0.284, 0.30, 0.97, density);
-
-		ChCoordsys<> base_position1m(ChVector<>(0 * spacing, 0.97, 0));
-		create_column(mphysicalSystem, base_position1m, nedges, 0.265, 0.284, 1.13, density);		//coordinate of the first group of columns, middle
-
-		ChCoordsys<> base_position1h(ChVector<>(0 * spacing, 2.1, 0));
-		create_column(mphysicalSystem, base_position1h, nedges, 0.25, 0.265, 1.15, density);		//coordinate of the first group of columns, top
-
-
-		//create column2
-
-		ChCoordsys<> base_position2l(ChVector<>(1 * spacing, 0, 0));	//coordinate of the second group of columns, bottom
-		create_column(mphysicalSystem, base_position2l, nedges, 0.283, 0.30, 1.05, density);
-
-		ChCoordsys<> base_position2m(ChVector<>(1 * spacing, 1.05, 0));
-		create_column(mphysicalSystem, base_position2m, nedges, 0.267, 0.283, 0.95, density);		//coordinate of the second group of columns, middle
-
-		ChCoordsys<> base_position2h(ChVector<>(1 * spacing, 2, 0));
-		create_column(mphysicalSystem, base_position2h, nedges, 0.25, 0.267, 1.25, density);		//coordinate of the second group of columns, top
-
-
-		//create column3
-
-		ChCoordsys<> base_position3l(ChVector<>(2 * spacing, 0, 0));	//coordinate of the third group of columns, bottom
-		create_column(mphysicalSystem, base_position3l, nedges, 0.284, 0.30, 0.95, density);
-
-		ChCoordsys<> base_position3m(ChVector<>(2 * spacing, 0.95, 0));
-		create_column(mphysicalSystem, base_position3m, nedges, 0.264, 0.284, 1.20, density);		//coordinate of the third group of columns, middle
-
-		ChCoordsys<> base_position3h(ChVector<>(2 * spacing, 2.15, 0));
-		create_column(mphysicalSystem, base_position3h, nedges, 0.25, 0.264, 1.1, density);		//coordinate of the third group of columns, top
-
-
-		//create column4
-
-		ChCoordsys<> base_position4l(ChVector<>(3 * spacing, 0, 0));	//coordinate of the fourth group of columns, bottom
-		create_column(mphysicalSystem, base_position4l, nedges, 0.278, 0.30, 1.33, density);
-
-		ChCoordsys<> base_position4m(ChVector<>(3 * spacing, 1.33, 0));
-		create_column(mphysicalSystem, base_position4m, nedges, 0.264, 0.278, 0.85, density);		//coordinate of the fourth group of columns, middle
-
-		ChCoordsys<> base_position4h(ChVector<>(3 * spacing, 2.18, 0));
-		create_column(mphysicalSystem, base_position4h, nedges, 0.25, 0.264, 1.07, density);		//coordinate of the fourth group of columns, top
-
-
-	//to create capitals
-
-		//create capital1
-
-		ChSharedPtr<ChBodyEasyBox> capital1(new ChBodyEasyBox(
-			0.7, 0.25, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capital1(ChVector<>(0, 3.375, 0));
-		capital1->SetCoord(cog_capital1);
-
-		mphysicalSystem.Add(capital1);
-
-		//create a texture for the capital1
-		ChSharedPtr<ChTexture> mtexturecapital1(new ChTexture());
-		mtexturecapital1->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capital1->AddAsset(mtexturecapital1);
-
-
-		//create capital2
-
-		ChSharedPtr<ChBodyEasyBox> capital2(new ChBodyEasyBox(
-			0.7, 0.25, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capital2(ChVector<>(spacing, 3.375, 0));
-		capital2->SetCoord(cog_capital2);
-
-		mphysicalSystem.Add(capital2);
-
-		//create a texture for the capital2
-		ChSharedPtr<ChTexture> mtexturecapital2(new ChTexture());
-		mtexturecapital2->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capital2->AddAsset(mtexturecapital2);
-
-
-		//create capital3
-
-		ChSharedPtr<ChBodyEasyBox> capital3(new ChBodyEasyBox(
-			0.7, 0.25, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capital3(ChVector<>(2 * spacing, 3.375, 0));
-		capital3->SetCoord(cog_capital3);
-
-		mphysicalSystem.Add(capital3);
-
-		//create a texture for the capital3
-		ChSharedPtr<ChTexture> mtexturecapital3(new ChTexture());
-		mtexturecapital3->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capital3->AddAsset(mtexturecapital3);
-
-
-		//create capital4
-
-		ChSharedPtr<ChBodyEasyBox> capital4(new ChBodyEasyBox(
-			0.7, 0.25, 0.7, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capital4(ChVector<>(3 * spacing, 3.375, 0));
-		capital4->SetCoord(cog_capital4);
-
-		mphysicalSystem.Add(capital4);
-
-		//create a texture for the capital4
-		ChSharedPtr<ChTexture> mtexturecapital4(new ChTexture());
-		mtexturecapital4->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capital4->AddAsset(mtexturecapital4);
-
-
-	//to create topBeam
-
-
-		//create topBeam1
-
-				ChSharedPtr<ChBodyEasyBox> topBeam1(new ChBodyEasyBox(
-			0.6+3*spacing, 0.75, 0.6, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_topBeam1(ChVector<>(3.748, 3.875, 0));
-		topBeam1->SetCoord(cog_topBeam1);
-
-		mphysicalSystem.Add(topBeam1);
-
-		//create a texture for the topBeam1
-		ChSharedPtr<ChTexture> mtexturetopBeam1(new ChTexture());
-		mtexturetopBeam1->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		topBeam1->AddAsset(mtexturetopBeam1);
-
-
-		//create topBeam2
-		
-		ChSharedPtr<ChBodyEasyBox> topBeam2(new ChBodyEasyBox(
-			3 * spacing, 0.45, 0.8, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_topBeam2(ChVector<>(3.7, 4.475, 0.1));
-		topBeam2->SetCoord(cog_topBeam2);
-
-		mphysicalSystem.Add(topBeam2);
-
-		//create a texture for the topBeam2
-		ChSharedPtr<ChTexture> mtexturetopBeam2(new ChTexture());
-		mtexturetopBeam2->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		topBeam2->AddAsset(mtexturetopBeam2);
-
-
-	//to create pedestals
-
-		//create pedestal1
-		ChCoordsys<> base_position1p(ChVector<>(0 * spacing, 4.7, 0));		//coordinate of the first pedestal of the "little" columns
-		create_column(mphysicalSystem, base_position1p, nedges, 0.175, 0.25, 0.20, density);
-
-
-		//create pedestal2
-		ChCoordsys<> base_position2p(ChVector<>(1 * spacing, 4.7, 0));		//coordinate of the second pedestal of the "little" columns
-		create_column(mphysicalSystem, base_position2p, nedges, 0.175, 0.25, 0.20, density);
-
-		//create pedestal3
-		ChCoordsys<> base_position3p(ChVector<>(2 * spacing, 4.7, 0));		//coordinate of the third pedestal of the "little" columns
-		create_column(mphysicalSystem, base_position3p, nedges, 0.175, 0.25, 0.20, density);
-
-
-	//to create "little" columns
-
-		//create little column1
-
-		ChCoordsys<> base_position1ll(ChVector<>(0 * spacing, 4.9, 0));	//coordinate of the first group of "little" columns, bottom
-		create_column(mphysicalSystem, base_position1ll, nedges, 0.164, 0.175, 1.14, density);
-
-		ChCoordsys<> base_position1lm(ChVector<>(0 * spacing, 6.04, 0));
-		plot_brick_1 = create_column(mphysicalSystem, base_position1lm, nedges, 0.15, 0.164, 1.41, density);		//coordinate of the first group of "little" columns, middle
-		// NOTE!!!!! the "plot_brick_1" points to this created column chunk, and plot_brick_1 is the one that will be plotted!!
-		
-
-		//create little column2
-
-		ChCoordsys<> base_position2ll(ChVector<>(1 * spacing, 4.9, 0));	//coordinate of the second group of "little" columns, bottom
-		create_column(mphysicalSystem, base_position2ll, nedges, 0.171, 0.175, 0.48, density);
-
-		ChCoordsys<> base_position2lm(ChVector<>(1 * spacing, 5.38, 0));
-		create_column(mphysicalSystem, base_position2lm, nedges, 0.157, 0.171, 1.44, density);		//coordinate of the second group of "little" columns, middle
-
-		ChCoordsys<> base_position2lh(ChVector<>(1 * spacing, 6.82, 0));
-		create_column(mphysicalSystem, base_position2lh, nedges, 0.150, 0.157, 0.63, density);		//coordinate of the second group of "little" columns, top
-
-
-		//create little column3
-
-		ChCoordsys<> base_position3ll(ChVector<>(2 * spacing, 4.9, 0));	//coordinate of the third group of "little" columns, bottom
-		create_column(mphysicalSystem, base_position3ll, nedges, 0.168, 0.175, 0.69, density);
-
-		ChCoordsys<> base_position3lm(ChVector<>(2 * spacing, 5.59, 0));
-		create_column(mphysicalSystem, base_position3lm, nedges, 0.15, 0.168, 1.86, density);		//coordinate of the third group of "little" columns, middle
-
-		
-		//to create capitals of little columns
-
-		//create capital1
-
-		ChSharedPtr<ChBodyEasyBox> capitall1(new ChBodyEasyBox(
-			0.45, 0.25, 0.45, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capitall1(ChVector<>(0, 7.595, 0));
-		capitall1->SetCoord(cog_capitall1);
-
-		mphysicalSystem.Add(capitall1);
-
-		//create a texture for the capital1
-		ChSharedPtr<ChTexture> mtexturecapitall1(new ChTexture());
-		mtexturecapitall1->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capitall1->AddAsset(mtexturecapitall1);
-
-
-		//create capital2
-
-		ChSharedPtr<ChBodyEasyBox> capitall2(new ChBodyEasyBox(
-			0.45, 0.25, 0.45, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capitall2(ChVector<>(spacing, 7.575, 0));
-		capitall2->SetCoord(cog_capitall2);
-
-		mphysicalSystem.Add(capitall2);
-
-		//create a texture for the capital2
-		ChSharedPtr<ChTexture> mtexturecapitall2(new ChTexture());
-		mtexturecapitall2->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capitall2->AddAsset(mtexturecapitall2);
-
-
-		//create capital3
-
-		ChSharedPtr<ChBodyEasyBox> capitall3(new ChBodyEasyBox(
-			0.45, 0.25, 0.45, // x y z sizes
-			density,
-			true,
-			true));
-
-		ChCoordsys<> cog_capitall3(ChVector<>(2 * spacing, 7.615, 0));
-		capitall3->SetCoord(cog_capitall3);
-
-		mphysicalSystem.Add(capitall3);
-
-		//create a texture for the capital3
-		ChSharedPtr<ChTexture> mtexturecapitall3(new ChTexture());
-		mtexturecapitall3->SetTextureFilename(GetChronoDataFile("whiteconcrete.jpg"));
-		capitall3->AddAsset(mtexturecapitall3);
-
-		
-		/*for (int icol = 0; icol <3; ++icol)
-		{
-
-
-		if (icol< 2)
+		ChSystem::IteratorBodies ibody = mphysicalSystem.IterBeginBodies();
+		while (ibody != mphysicalSystem.IterEndBodies())
 		{
-		ChSharedPtr<ChBodyEasyBox> bodyTop(new ChBodyEasyBox(
-		spacing, 0.4, 0.6, // x y z sizes
-		density,
-		true,
-		true));
-
-		ChCoordsys<> cog_top(ChVector<>(icol * spacing + spacing/2, 3 + 0.4/2, 0));
-		bodyTop->SetCoord( cog_top );
-
-		mphysicalSystem.Add(bodyTop);
-
-		//create a texture for the bodyTop
-		ChSharedPtr<ChTexture> mtextureebodyTop(new ChTexture());
-		mtextureebodyTop->SetTextureFilename(GetChronoDataFile("oldconcrete.jpg"));
-		bodyTop->AddAsset(mtextureebodyTop);
+			pending_assets.push_back(*ibody);
+			++ibody;
 		}
-
-		if (icol< 2)
-		{
-		ChSharedPtr<ChBodyEasyBox> bodyTop(new ChBodyEasyBox(
-		spacing, 1.4, 0.6, // x y z sizes
-		density,
-		true,
-		true));
-
-		ChCoordsys<> cog_top(ChVector<>(icol * spacing + spacing / 2, 6 + 1.4 / 2, 4));
-		bodyTop->SetCoord(cog_top);
-
-		mphysicalSystem.Add(bodyTop);
-
-		//create a texture for the bodyTop
-		ChSharedPtr<ChTexture> mtexturebodyTop(new ChTexture());
-		mtexturebodyTop->SetTextureFilename(GetChronoDataFile("brick.jpg"));
-		bodyTop->AddAsset(mtexturebodyTop);
-		}
-		}*/
-
-
 	}
+	conversion_timer.stop();
+	unsigned int next_asset = 0;
+	bool shadows_pending = (shadows == "deferred");
+	bool first_frame = true;
 
 
-	
-	// Use this function for adding a ChIrrNodeAsset to all items
-	// Otherwise use application.AssetBind(myitem); on a per-item basis.
-	application.AssetBindAll();
-
-	// Use this function for 'converting' assets into Irrlicht meshes 
-	application.AssetUpdateAll();
-
-	// This is to enable shadow maps (shadow casting with soft shadows) in Irrlicht
-	// for all objects (or use application.AddShadow(..) for enable shadow on a per-item basis)
-
-	application.AddShadowAll();
-
-
-	// Modify some setting of the physical system for the simulation, if you want
-	//mphysicalSystem.SetLcpSolverType(ChSystem::LCP_ITERATIVE_SOR);
-	mphysicalSystem.SetLcpSolverType(ChSystem::LCP_ITERATIVE_BARZILAIBORWEIN); // slower but more pricise
-	mphysicalSystem.SetIterLCPmaxItersSpeed(80);
-	mphysicalSystem.SetIterLCPmaxItersStab(5);
-
-
-	//mphysicalSystem.SetUseSleeping(true);
-
 	application.SetStepManage(true);
-	application.SetTimestep(0.005);
+	application.SetTimestep(mcase.timestep);
 	application.SetTryRealtime(false);
 
 
-	// Files for output data
-	ChStreamOutAsciiFile data_earthquake_x("data_earthquake_x.dat");
-	ChStreamOutAsciiFile data_earthquake_y("data_earthquake_y.dat");
-	ChStreamOutAsciiFile data_earthquake_x_NB("data_earthquake_x_NB.dat");
-	ChStreamOutAsciiFile data_earthquake_y_NB("data_earthquake_y_NB.dat");
-	ChStreamOutAsciiFile data_table("data_table.dat");
-	ChStreamOutAsciiFile data_brick_1("data_brick_1.dat");
-	ChStreamOutAsciiFile data_brick_2("data_brick_2.dat");
+	// Metrics, spectra and output data files
+	RunMonitor monitor(mphysicalSystem, model, mcase);
 
 
 	// 
 	// THE SOFT-REAL-TIME CYCLE
 	//
-	ChVector<> brick_initial_displacement;
 
 	while (application.GetDevice()->run())
 	{
+		for (int k = 0; k < asset_batch && next_asset < pending_assets.size(); ++k, ++next_asset)
+		{
+			application.AssetBind(pending_assets[next_asset]);
+			application.AssetUpdate(pending_assets[next_asset]);
+			attach_shared_mesh(application, model, pending_assets[next_asset].get_ptr());
+			if (shadows == "all")
+				application.AddShadow(pending_assets[next_asset]);
+		}
+
 		application.GetVideoDriver()->beginScene(true, true, SColor(255, 140, 161, 192));
 
 		application.DrawAll();
 
-		application.DoStep();
-
-		// save data for plotting
-		double time = mphysicalSystem.GetChTime();
-
-		if (time <4.5)
-			brick_initial_displacement = plot_brick_1->GetPos() - plot_table->GetPos();
-		
-		if (time >4.5)  // save only after 4.5 s to avoid plotting initial settlement
 		{
-			data_earthquake_x << time << " " 
-							  << mmotion_x->Get_y(time) << " "
-							  << mmotion_x->Get_y_dx(time) << " "
-							  << mmotion_x->Get_y_dxdx(time) << "\n";
-
-			data_earthquake_y << time << " " 
-							  << mmotion_y->Get_y(time) << " "
-							  << mmotion_y->Get_y_dx(time) << " "
-							  << mmotion_y->Get_y_dxdx(time) << "\n";
-
-			data_earthquake_x_NB << time << " " 
-							  << mmotion_x_NB->Get_y(time) << " "
-							  << mmotion_x_NB->Get_y_dx(time) << " "
-							  << mmotion_x_NB->Get_y_dxdx(time) << "\n";
-
-			data_earthquake_y_NB << time << " " 
-							  << mmotion_y_NB->Get_y(time) << " "
-							  << mmotion_y_NB->Get_y_dx(time) << " "
-							  << mmotion_y_NB->Get_y_dxdx(time) << "\n";
-
-			data_table	<< mphysicalSystem.GetChTime() << " " 
-						<< plot_table->GetPos().x -4.05 << " "  // because created at x=4.05, and we want to plot from 0
-						<< plot_table->GetPos().y +0.5 << " "
-						<< plot_table->GetPos().z << " "
-						<< plot_table->GetPos_dt().x << " "
-						<< plot_table->GetPos_dt().y << " "
-						<< plot_table->GetPos_dt().z << " "
-						<< plot_table->GetPos_dtdt().x << " "
-						<< plot_table->GetPos_dtdt().y << " "
-						<< plot_table->GetPos_dtdt().z << "\n";
-
-			ChFrameMoving<> rel_motion;
-			plot_table->TransformParentToLocal(plot_brick_1->GetFrame_REF_to_abs(), rel_motion);
-
-			data_brick_1 << mphysicalSystem.GetChTime() << " " 
-						<< rel_motion.GetPos().x - brick_initial_displacement.x << " "  
-						<< rel_motion.GetPos().y - brick_initial_displacement.y << " "
-						<< rel_motion.GetPos().z - brick_initial_displacement.z << " "
-						<< rel_motion.GetPos_dt().x << " "
-						<< rel_motion.GetPos_dt().y << " "
-						<< rel_motion.GetPos_dt().z << " "
-						<< rel_motion.GetPos_dtdt().x << " "
-						<< rel_motion.GetPos_dtdt().y << " "
-						<< rel_motion.GetPos_dtdt().z << "\n";
-
-			ChFrameMoving<> rel_motion_2;
-			plot_table->TransformParentToLocal(plot_brick_2->GetFrame_REF_to_abs(), rel_motion_2);
-
-			data_brick_2 << mphysicalSystem.GetChTime() << " "
-				<< rel_motion_2.GetPos().x - brick_initial_displacement.x << " "
-				<< rel_motion_2.GetPos().y - brick_initial_displacement.y << " "
-				<< rel_motion_2.GetPos().z - brick_initial_displacement.z << " "
-				<< rel_motion_2.GetPos_dt().x << " "
-				<< rel_motion_2.GetPos_dt().y << " "
-				<< rel_motion_2.GetPos_dt().z << " "
-				<< rel_motion_2.GetPos_dtdt().x << " "
-				<< rel_motion_2.GetPos_dtdt().y << " "
-				<< rel_motion_2.GetPos_dtdt().z << "\n";
-			
-			// end plotting data logout
+			MemoryScope scope(&memory, MEMORY_SIMULATION);
+			application.DoStep();
+
+			// save data for plotting
+			monitor.Update();
 		}
 
 		application.GetVideoDriver()->endScene();
 
+		if (first_frame)
+		{
+			startup_timer.stop();
+			GetLog() << "Time to first frame: " << startup_timer() << " s (model construction "
+					 << construction_timer() << " s, visual assets " << conversion_timer() << " s) \n";
+			first_frame = false;
+		}
+		else if (shadows_pending && next_asset >= pending_assets.size())
+		{
+			// all assets are converted: now the shadows
+			application.AddShadowAll();
+			shadows_pending = false;
+		}
+
 		// Exit simulation if time greater than ..
-		if (mphysicalSystem.GetChTime() > 9) 
+		if (mphysicalSystem.GetChTime() > mcase.t_end) 
 			break;
 	}
 
+	monitor.Finish();
+	report_memory(memory, mphysicalSystem, mcase);
+
 
 	// optional: automate the plotting launching GNUplot with a commandfile
 
@@ -0,0 +1,396 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   Microbenchmarks of the pieces of a temple run:
+//
+//     - parsing of the records into motion functions
+//     - evaluation of the motion functions
+//     - cost per step of multi-component motions
+//     - construction of the temple models
+//     - cost of one time step, simple and complex temple,
+//       and with the material table instead of one material
+//     - check of the batched relative kinematics against
+//       the per-body transformation (exits with 1 if they differ)
+//
+//   Results are appended to bench.dat, one line per
+//   measurement:  tag  benchmark  value  unit
+//   where the tag (ex. a version) is given with --tag
+//
+///////////////////////////////////////////////////
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "core/ChTimer.h"
+#include "physics/ChSystem.h"
+
+#include "terremoto_model.h"
+#include "terremoto_records.h"
+#include "terremoto_motion.h"
+#include "terremoto_run.h"
+#include "terremoto_files.h"
+
+using namespace chrono;
+
+
+// Where the results go: the log, and a line appended to the results file.
+
+class BenchOutput
+{
+public:
+	BenchOutput(const std::string& filename, const std::string& mtag) : tag(mtag)
+	{
+		bool exists = std::ifstream(filename.c_str()).good();
+		out.open(filename.c_str(), std::ios::app);
+		out.precision(8);
+		if (!exists)
+			out << "# tag  benchmark  value  unit\n";
+	}
+
+	void Add(const std::string& name, double value, const char* unit)
+	{
+		char line[300];
+		sprintf(line, "%-40s %14.6g %s\n", name.c_str(), value, unit);
+		GetLog() << line;
+		out << tag << "\t" << name << "\t" << value << "\t" << unit << "\n";
+		out.flush();
+	}
+
+private:
+	std::string tag;
+	std::ofstream out;
+};
+
+
+// Parse time per MB of the selected records: create_motion() on the text
+// files, MotionRecord::LoadText(), and the library path (binary form).
+
+static void bench_parsing(BenchOutput& output, const RecordLibrary& library, const std::vector<const RecordInfo*>& records)
+{
+	double megabytes = 0;
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		long long size = file_size(join_path(library.GetDirectory(), records[i]->path));
+		if (size > 0)
+			megabytes += size / (1024.0 * 1024.0);
+	}
+	if (megabytes <= 0)
+		return;
+
+	ChTimer<double> timer;
+
+	timer.start();
+	for (size_t i = 0; i < records.size(); ++i)
+		delete create_motion(records[i]->path);
+	timer.stop();
+	output.Add("parse_create_motion", timer() / megabytes, "s/MB");
+
+	timer.reset();
+	timer.start();
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		MotionRecord record;
+		record.LoadText(join_path(library.GetDirectory(), records[i]->path));
+	}
+	timer.stop();
+	output.Add("parse_load_text", timer() / megabytes, "s/MB");
+
+	timer.reset();
+	timer.start();
+	for (size_t i = 0; i < records.size(); ++i)
+		delete library.CreateMotion(*records[i]);
+	timer.stop();
+	output.Add("parse_library_create_motion", timer() / megabytes, "s/MB");
+}
+
+
+// Cost of Get_y, Get_y_dx, Get_y_dxdx, evaluated at the solver times
+// along the whole motion, as the link does during a run.
+
+static void bench_evaluation(BenchOutput& output, const std::string& name, ChFunction* motion, double dt)
+{
+	double t_min, t_max;
+	motion->Estimate_x_range(t_min, t_max);
+	int nt = (int)((t_max - t_min) / dt) + 1;
+	const int ncalls = 2000000;
+
+	volatile double sink = 0;
+	ChTimer<double> timer;
+	for (int derivative = 0; derivative < 3; ++derivative)
+	{
+		timer.reset();
+		timer.start();
+		for (int i = 0; i < ncalls; ++i)
+		{
+			double t = t_min + dt * (double)(i % nt);
+			switch (derivative)
+			{
+			case 0: sink = sink + motion->Get_y(t);      break;
+			case 1: sink = sink + motion->Get_y_dx(t);   break;
+			case 2: sink = sink + motion->Get_y_dxdx(t); break;
+			}
+		}
+		timer.stop();
+		static const char* suffix[3] = { "_get_y", "_get_y_dx", "_get_y_dxdx" };
+		output.Add("eval_" + name + suffix[derivative], 1e9 * timer() / ncalls, "ns/call");
+	}
+}
+
+
+// Cost per step of the motion of 1 to 6 components, each evaluated with its
+// derivatives as by the link: from one multi-component motion, and from
+// one spline per component.
+
+static void bench_components(BenchOutput& output, double dt)
+{
+	const size_t nsamples = 20000;
+	const int nsteps = 1000000;
+	std::vector<double> rows(nsamples * MOTION_NCOMPONENTS);
+	std::vector< std::vector<double> > columns(MOTION_NCOMPONENTS, std::vector<double>(nsamples));
+	for (size_t i = 0; i < nsamples; ++i)
+		for (int c = 0; c < MOTION_NCOMPONENTS; ++c)
+			columns[c][i] = sin(0.01 * (double)i * (1.0 + 0.3 * c));
+
+	static const int counts[4] = { 1, 2, 3, 6 };
+	volatile double sink = 0;
+	for (int k = 0; k < 4; ++k)
+	{
+		int nc = counts[k];
+		for (size_t i = 0; i < nsamples; ++i)
+			for (int c = 0; c < nc; ++c)
+				rows[i * nc + c] = columns[c][i];
+
+		std::shared_ptr<MultiComponentMotion> multi(new MultiComponentMotion);
+		multi->Setup(0, 0.01, nc, std::vector<double>(rows.begin(), rows.begin() + nsamples * nc));
+		std::vector<ChFunction*> components;
+		std::vector<ChFunction*> splines;
+		for (int c = 0; c < nc; ++c)
+		{
+			components.push_back(new MotionComponent(multi, c));
+			splines.push_back(new MotionSpline(0, 0.01, columns[c]));
+		}
+
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			std::vector<ChFunction*>& functions = (pass == 0) ? components : splines;
+			ChTimer<double> timer;
+			timer.start();
+			for (int i = 0; i < nsteps; ++i)
+			{
+				double t = dt * (double)(i % (int)(199.0 / dt));
+				for (int c = 0; c < nc; ++c)
+					sink = sink + functions[c]->Get_y(t) + functions[c]->Get_y_dx(t) + functions[c]->Get_y_dxdx(t);
+			}
+			timer.stop();
+			char name[100];
+			sprintf(name, "components_%d_%s", nc, (pass == 0) ? "multi" : "separate");
+			output.Add(name, 1e9 * timer() / nsteps, "ns/step");
+		}
+
+		for (int c = 0; c < nc; ++c)
+		{
+			delete components[c];
+			delete splines[c];
+		}
+	}
+}
+
+
+// Construction time of the temple model in a new system
+
+static void bench_construction(BenchOutput& output, bool simple_temple)
+{
+	const int nrep = 5;
+	ChTimer<double> timer;
+	for (int i = 0; i < nrep; ++i)
+	{
+		ChSystem* msystem = new ChSystem;
+		TempleModel model;
+		timer.start();
+		create_temple(*msystem, model, simple_temple);
+		timer.stop();
+		delete msystem;
+	}
+	output.Add(simple_temple ? "construct_simple_temple" : "construct_complex_temple", timer() / nrep, "s");
+}
+
+
+// Cost of one time step during the shaking (the motion starts at once),
+// and the memory of the instance. With the material table, the contacts
+// get the same parameters as with the single material, through the table.
+
+static void bench_step(BenchOutput& output, const RecordLibrary& library, const RunCase& base, bool simple_temple, bool material_table = false)
+{
+	RunCase bcase = base;
+	bcase.simple_temple = simple_temple;
+	bcase.time_offset = 0;
+	if (material_table)
+		bcase.material_pairs.push_back(MaterialPair(MATERIAL_MARBLE, MATERIAL_MARBLE, MaterialTable(bcase.material).GetPair(MATERIAL_MARBLE, MATERIAL_MARBLE)));
+
+	MemoryAccount memory("bench");
+	ChSystem mphysicalSystem;
+	TempleModel model;
+	if (!setup_case(mphysicalSystem, model, bcase, library, &memory))
+		return;
+
+	MemoryScope scope(&memory, MEMORY_SIMULATION);
+
+	const int nwarm = 100;
+	const int nsteps = 400;
+	for (int i = 0; i < nwarm; ++i)
+		mphysicalSystem.DoStepDynamics(bcase.timestep);
+
+	ChTimer<double> timer;
+	timer.start();
+	for (int i = 0; i < nsteps; ++i)
+		mphysicalSystem.DoStepDynamics(bcase.timestep);
+	timer.stop();
+
+	std::string name = simple_temple ? "step_simple_temple" : "step_complex_temple";
+	if (material_table)
+		name += "_material_table";
+	output.Add(name, timer() / nsteps, "s");
+	output.Add(name + "_contacts", (double)mphysicalSystem.GetNcontacts(), "contacts");
+
+	if (MemoryAccount::IsEnabled() && !material_table)
+	{
+		std::string mname = simple_temple ? "memory_simple_temple" : "memory_complex_temple";
+		output.Add(mname + "_per_body", (double)memory.GetBytes(MEMORY_BODIES) / mphysicalSystem.GetNbodies(), "B");
+		output.Add(mname + "_records", (double)memory.GetBytes(MEMORY_RECORDS), "B");
+		output.Add(mname + "_contacts", (double)memory.GetBytes(MEMORY_CONTACTS), "B");
+		output.Add(mname + "_simulation", (double)memory.GetBytes(MEMORY_SIMULATION), "B");
+		output.Add(mname + "_peak", (double)memory.GetPeakBytes(), "B");
+	}
+}
+
+
+
+// Check of the batched relative kinematics of RunMonitor against the per-body
+// TransformParentToLocal() it replaced, on a short run with the motion from
+// the start: max differences of the brick displacements and of the drum
+// tilts. Returns false if they differ beyond round-off.
+
+static bool bench_kinematics(BenchOutput& output, const RecordLibrary& library, const RunCase& base)
+{
+	RunCase kcase = base;
+	kcase.simple_temple = false;		// with drums
+	kcase.time_offset = 0;
+	kcase.t_save = 0;					// no initial settlement subtracted
+	kcase.save_full_dumps = false;
+
+	ChSystem mphysicalSystem;
+	TempleModel model;
+	if (!setup_case(mphysicalSystem, model, kcase, library))
+		return false;
+	RunMonitor monitor(mphysicalSystem, model, kcase);
+
+	double max_error_displacement = 0;
+	double max_error_tilt = 0;
+	const int nsteps = 200;
+	for (int i = 0; i < nsteps; ++i)
+	{
+		mphysicalSystem.DoStepDynamics(kcase.timestep);
+		monitor.Update();
+
+		ChFrameMoving<> rel_motion_1, rel_motion_2;
+		model.table->TransformParentToLocal(model.plot_brick_1->GetFrame_REF_to_abs(), rel_motion_1);
+		model.table->TransformParentToLocal(model.plot_brick_2->GetFrame_REF_to_abs(), rel_motion_2);
+		max_error_displacement = std::max(max_error_displacement, (monitor.GetBrick1Displacement() - rel_motion_1.GetPos()).Length());
+		max_error_displacement = std::max(max_error_displacement, (monitor.GetBrick2Displacement() - rel_motion_2.GetPos()).Length());
+
+		ChQuaternion<> table_rot_conj = Qconjugate(model.table->GetRot());
+		const std::vector<double>& tilts = monitor.GetDrumTilts();
+		for (size_t idrum = 0; idrum < model.drums.size(); ++idrum)
+		{
+			double tilt = ResponseMetrics::TiltAngle(Qcross(table_rot_conj, model.drums[idrum]->GetRot()));
+			max_error_tilt = std::max(max_error_tilt, fabs(tilts[idrum] - tilt));
+		}
+	}
+	output.Add("kinematics_max_error_displacement", max_error_displacement, "m");
+	output.Add("kinematics_max_error_tilt", max_error_tilt, "rad");
+
+	if (max_error_displacement > 1e-9 || max_error_tilt > 1e-9)
+	{
+		GetLog() << "The batched relative kinematics differ from TransformParentToLocal() \n";
+		return false;
+	}
+	return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+	std::string query = "quantity=U direction=h";
+	std::string output_filename = "bench.dat";
+	std::string tag = "current";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if      (!strcmp(argv[i], "--query") && i + 1 < argc) query = argv[++i];
+		else if (!strcmp(argv[i], "--out")   && i + 1 < argc) output_filename = argv[++i];
+		else if (!strcmp(argv[i], "--tag")   && i + 1 < argc) tag = argv[++i];
+		else
+		{
+			GetLog() << "Usage: terremoto_bench [--query \"<records>\"] [--out bench.dat] [--tag <version>] \n"
+					 << "Records are taken from the library in the data directory, as create_motion() does. \n";
+			return 1;
+		}
+	}
+
+	RecordLibrary library;
+	library.Open(GetChronoDataFile(""));
+	std::vector<const RecordInfo*> records = library.Select(query);
+	if (records.empty())
+	{
+		GetLog() << "No records match " << query.c_str() << "\n";
+		return 1;
+	}
+
+	BenchOutput output(output_filename, tag);
+	RunCase base;
+	base.record_set = records[0]->set;
+	base.record_h   = records[0]->name;
+	const RecordInfo* companion = library.FindCompanion(*records[0]);
+	base.record_v   = companion ? companion->name : "";
+
+	bench_parsing(output, library, records);
+
+	ChFunction* motion_text = create_motion(records[0]->path);
+	bench_evaluation(output, "recorder", motion_text, base.timestep);
+	delete motion_text;
+
+	MotionRecord record;
+	if (library.Load(*records[0], record))
+	{
+		MotionSpline* motion_spline = create_preprocessed_motion(record, records[0]->quantity, base.preprocessing, base.timestep);
+		bench_evaluation(output, "spline", motion_spline, base.timestep);
+		delete motion_spline;
+	}
+
+	bench_components(output, base.timestep);
+
+	bench_construction(output, true);
+	bench_construction(output, false);
+
+	bench_step(output, library, base, true);
+	bench_step(output, library, base, false);
+	bench_step(output, library, base, false, true);
+
+	return bench_kinematics(output, library, base) ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include "terremoto_capture.h"
+
+
+CaptureSettings::CaptureSettings()
+{
+	decimation = 1;
+	contact_impulse = 0;
+	rel_acc = 0;
+	tilt_rate = 0;
+	t_before = 0.25;
+	t_after = 0.5;
+}
+
+
+
+EventCapture::EventCapture(int mnchannels, int msteps_before, int msteps_after)
+	: nchannels(mnchannels),
+	  steps_after(msteps_after),
+	  ring((msteps_before + 1) * mnchannels),
+	  ring_time(msteps_before + 1),
+	  head(0),
+	  count(0),
+	  filenames(mnchannels),
+	  fields(mnchannels, 1),
+	  files(mnchannels, (std::ofstream*)0),
+	  events_file(0),
+	  nevents(0),
+	  remaining(0),
+	  event_time(0),
+	  event_value(0),
+	  first_time(0),
+	  last_time(0)
+{
+}
+
+EventCapture::~EventCapture()
+{
+	if (remaining > 0)
+		CloseEvent();
+	for (int c = 0; c < nchannels; ++c)
+		delete files[c];
+	delete events_file;
+}
+
+void EventCapture::SetChannel(int channel, const std::string& filename, int mfields)
+{
+	filenames[channel] = filename;
+	fields[channel] = mfields;
+}
+
+void EventCapture::SetEventsFile(const std::string& filename)
+{
+	events_filename = filename;
+}
+
+void EventCapture::WriteRows(const std::vector<double>* rows)
+{
+	for (int c = 0; c < nchannels; ++c)
+	{
+		if (!files[c])
+			continue;
+		const std::vector<double>& row = rows[c];
+		for (size_t i = 0; i + fields[c] <= row.size(); i += fields[c])
+		{
+			*files[c] << nevents;
+			for (int k = 0; k < fields[c]; ++k)
+				*files[c] << " " << row[i + k];
+			*files[c] << "\n";
+		}
+	}
+}
+
+void EventCapture::CloseEvent()
+{
+	if (events_file)
+		*events_file << nevents << " " << event_time << " " << event_trigger << " " << event_value << " "
+					 << first_time << " " << last_time << "\n";
+	remaining = 0;
+
+	// the buffered steps are written already: a next event starts afresh
+	count = 0;
+}
+
+void EventCapture::Push(double time, const std::vector<double>* rows, const char* trigger, double value)
+{
+	if (remaining > 0)
+	{
+		// capture open: the steps go straight to the files
+		WriteRows(rows);
+		last_time = time;
+		if (trigger)
+			remaining = steps_after;
+		else
+			--remaining;
+		if (remaining == 0)
+			CloseEvent();
+		return;
+	}
+
+	size_t nslots = ring_time.size();
+	for (int c = 0; c < nchannels; ++c)
+		ring[head * nchannels + c].assign(rows[c].begin(), rows[c].end());
+	ring_time[head] = time;
+	head = (head + 1) % nslots;
+	if (count < nslots)
+		++count;
+
+	if (!trigger)
+		return;
+
+	// New event: create the files at the first one, then dump the ring,
+	// oldest step first (this step included)
+	++nevents;
+	if (nevents == 1)
+	{
+		if (!events_filename.empty())
+		{
+			events_file = new std::ofstream(events_filename.c_str());
+			*events_file << "# event  t_trigger  trigger  value  t_first  t_last\n";
+		}
+		for (int c = 0; c < nchannels; ++c)
+			if (!filenames[c].empty())
+				files[c] = new std::ofstream(filenames[c].c_str());
+	}
+	event_time = time;
+	event_trigger = trigger;
+	event_value = value;
+	size_t oldest = (head + nslots - count) % nslots;
+	first_time = ring_time[oldest];
+	last_time = time;
+	for (size_t k = 0; k < count; ++k)
+		WriteRows(&ring[((oldest + k) % nslots) * nchannels]);
+
+	remaining = steps_after;
+	if (remaining == 0)
+		CloseEvent();
+}
@@ -0,0 +1,105 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_CAPTURE_H
+#define TERREMOTO_CAPTURE_H
+
+///////////////////////////////////////////////////
+//
+//   Event-triggered capture of the time histories:
+//   the full dumps are written at a decimated base
+//   rate, while the last steps are kept at full
+//   rate in a ring buffer. When a trigger fires
+//   (an impact, a peak of acceleration or of tilt
+//   rate) the buffer, and the steps that follow,
+//   are written to separate capture files.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+
+/// Settings of the decimated logging and of the triggers.
+
+class CaptureSettings
+{
+public:
+	CaptureSettings();
+
+		/// True if some trigger is set
+	bool IsEnabled() const { return contact_impulse > 0 || rel_acc > 0 || tilt_rate > 0; }
+
+	int    decimation;		// full dumps written every this many steps
+	double contact_impulse;	// trigger on the change, in a step, of the normal impulse of an interface, N s (0 for none)
+	double rel_acc;			// trigger on the acceleration of a brick relative to the table, m/s^2 (0 for none)
+	double tilt_rate;		// trigger on the tilt rate of a drum, rad/s (0 for none)
+	double t_before;		// captured before the trigger, s
+	double t_after;			// captured after the last trigger, s
+};
+
+
+/// Ring buffer of the rows of some channels (one row per channel and
+/// step, with a number of fields per line; a row may hold several lines),
+/// dumped to the capture files around each event:
+///     <channel file>   event  fields...
+///     <events file>    event  t_trigger  trigger  value  t_first  t_last
+/// Files are created at the first event. A trigger that fires during a
+/// capture extends it.
+
+class EventCapture
+{
+public:
+	EventCapture(int mnchannels, int msteps_before, int msteps_after);
+
+		/// Writes the event of a capture still open.
+	~EventCapture();
+
+	void SetChannel(int channel, const std::string& filename, int fields);
+	void SetEventsFile(const std::string& filename);
+
+		/// Store the rows of a step (an array of one row per channel); if
+		/// a trigger fired (trigger not null), start or extend a capture.
+	void Push(double time, const std::vector<double>* rows, const char* trigger = 0, double value = 0);
+
+	int GetNevents() const { return nevents; }
+
+private:
+	void WriteRows(const std::vector<double>* rows);
+	void CloseEvent();
+
+	int nchannels;
+	int steps_after;
+
+	// ring of the last steps: rows[slot * nchannels + channel]
+	std::vector< std::vector<double> > ring;
+	std::vector<double> ring_time;
+	size_t head;
+	size_t count;
+
+	std::vector<std::string> filenames;
+	std::vector<int> fields;
+	std::vector<std::ofstream*> files;
+	std::string events_filename;
+	std::ofstream* events_file;
+
+	int nevents;
+	int remaining;			// steps still to capture, 0 if no capture is open
+	double event_time;
+	double event_value;
+	std::string event_trigger;
+	double first_time;
+	double last_time;
+};
+
+
+#endif
@@ -0,0 +1,159 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cmath>
+#include <algorithm>
+
+#include "terremoto_contacts.h"
+#include "terremoto_memory.h"
+
+using namespace chrono;
+
+
+ContactInterfaces::ContactInterfaces(ChSystem& mphysicalSystem) : msystem(&mphysicalSystem), step(0)
+{
+	ChSystem::IteratorBodies ibody = mphysicalSystem.IterBeginBodies();
+	while (ibody != mphysicalSystem.IterEndBodies())
+	{
+		ChBody* body = (*ibody).get_ptr();
+		body_index[body] = (int)bodies.size();
+		bodies.push_back(body);
+		++ibody;
+	}
+	size_t n = bodies.size();
+	pair_table.assign(n * n, -1);
+
+	// a stack of n bodies has about n interfaces
+	size_t nreserve = 2 * n;
+	body_a.reserve(nreserve);
+	body_b.reserve(nreserve);
+	n_contacts.reserve(nreserve);
+	normal_force.reserve(nreserve);
+	friction_force.reserve(nreserve);
+	penetration.reserve(nreserve);
+	slip_rate.reserve(nreserve);
+	stamp.reserve(nreserve);
+	friction_sum.reserve(nreserve);
+	slip_weight.reserve(nreserve);
+	slip_sum.reserve(nreserve);
+	active.reserve(nreserve);
+}
+
+int ContactInterfaces::GetInterface(int ia, int ib)
+{
+	if (ia > ib)
+		std::swap(ia, ib);
+	int& iface = pair_table[ia * bodies.size() + ib];
+	if (iface < 0)
+	{
+		iface = (int)body_a.size();
+		body_a.push_back(ia);
+		body_b.push_back(ib);
+		n_contacts.push_back(0);
+		normal_force.push_back(0);
+		friction_force.push_back(0);
+		penetration.push_back(0);
+		slip_rate.push_back(0);
+		stamp.push_back(-1);
+		friction_sum.push_back(VNULL);
+		slip_weight.push_back(0);
+		slip_sum.push_back(0);
+	}
+	return iface;
+}
+
+void ContactInterfaces::Update()
+{
+	MemoryScope scope(MEMORY_CONTACTS);
+
+	++step;
+	active.clear();
+	msystem->GetContactContainer()->ReportAllContacts(this);
+
+	// interfaces in a fixed order, whatever the order of the contacts
+	std::sort(active.begin(), active.end(), [this](int i, int j)
+	{
+		return (body_a[i] != body_a[j]) ? body_a[i] < body_a[j] : body_b[i] < body_b[j];
+	});
+
+	for (size_t k = 0; k < active.size(); ++k)
+	{
+		int i = active[k];
+		friction_force[i] = friction_sum[i].Length();
+		slip_rate[i] = (slip_weight[i] > 0) ? slip_rate[i] / slip_weight[i] : slip_sum[i] / n_contacts[i];
+	}
+}
+
+bool ContactInterfaces::ReportContactCallback(const ChVector<>& pA,
+											  const ChVector<>& pB,
+											  const ChMatrix33<>& plane_coord,
+											  const double& distance,
+											  const float& /*mfriction*/,
+											  const ChVector<>& react_forces,
+											  const ChVector<>& /*react_torques*/,
+											  collision::ChCollisionModel* modA,
+											  collision::ChCollisionModel* modB)
+{
+	std::unordered_map<ChPhysicsItem*, int>::const_iterator fa = body_index.find(modA->GetPhysicsItem());
+	std::unordered_map<ChPhysicsItem*, int>::const_iterator fb = body_index.find(modB->GetPhysicsItem());
+	if (fa == body_index.end() || fb == body_index.end())
+		return true;	// not a body (or added after the start): skip, continue scanning
+
+	int i = GetInterface(fa->second, fb->second);
+	if (stamp[i] != step)
+	{
+		stamp[i] = step;
+		active.push_back(i);
+		n_contacts[i] = 0;
+		normal_force[i] = 0;
+		penetration[i] = 0;
+		slip_rate[i] = 0;
+		friction_sum[i] = VNULL;
+		slip_weight[i] = 0;
+		slip_sum[i] = 0;
+	}
+
+	// reactions are in the contact plane coordinates: x normal, y z tangent
+	ChVector<> normal = plane_coord.Get_A_Xaxis();
+	ChVector<> tangent_force = plane_coord.Matr_x_Vect(ChVector<>(0, react_forces.y, react_forces.z));
+
+	// the interface orders its bodies by index: sum the force on the same
+	// body whatever the order Chrono reports the contact in
+	if (fa->second > fb->second)
+		tangent_force = -tangent_force;
+
+	// tangential relative speed of the two contact points
+	const ChBody* bA = bodies[fa->second];
+	const ChBody* bB = bodies[fb->second];
+	ChVector<> vA = bA->GetPos_dt() + Vcross(bA->GetWvel_par(), pA - bA->GetPos());
+	ChVector<> vB = bB->GetPos_dt() + Vcross(bB->GetWvel_par(), pB - bB->GetPos());
+	ChVector<> vrel = vA - vB;
+	double slip = (vrel - normal * Vdot(vrel, normal)).Length();
+
+	double fn = fabs(react_forces.x);
+	n_contacts[i] += 1;
+	normal_force[i] += fn;
+	friction_sum[i] += tangent_force;
+	penetration[i] = std::max(penetration[i], -distance);
+	slip_rate[i] += fn * slip;
+	slip_weight[i] += fn;
+	slip_sum[i] += slip;
+
+	return true;
+}
+
+
+
+void AccountedContactContainer::AddContact(const collision::ChCollisionInfo& mcontact)
+{
+	MemoryScope scope(MEMORY_CONTACTS);
+	ChContactContainer::AddContact(mcontact);
+}
@@ -0,0 +1,102 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_CONTACTS_H
+#define TERREMOTO_CONTACTS_H
+
+///////////////////////////////////////////////////
+//
+//   Contact forces and sliding at the interfaces
+//   between bodies (drum to drum, drum to capital,
+//   etc.), reduced per body pair at each step.
+//
+///////////////////////////////////////////////////
+
+#include <vector>
+#include <unordered_map>
+
+#include "physics/ChSystem.h"
+#include "physics/ChBody.h"
+#include "physics/ChContactContainerBase.h"
+#include "physics/ChContactContainer.h"
+
+
+/// Per-interface resultants of the contacts of a system. An interface is
+/// a pair of bodies in contact; bodies are numbered as in the system, in
+/// creation order. Call Update() after each time step: it walks the
+/// contacts once and reduces them into the per-interface arrays below.
+///
+/// The body table is built once; interfaces are added to the pair table
+/// the first time the pair touches, so no memory is allocated per contact.
+
+class ContactInterfaces : public chrono::ChReportContactCallback
+{
+public:
+	ContactInterfaces(chrono::ChSystem& mphysicalSystem);
+
+		/// Reduce the contacts of the current step.
+	void Update();
+
+		/// Interfaces with contacts at the last Update(), sorted by body pair.
+	const std::vector<int>& GetActive() const { return active; }
+
+	int GetNinterfaces() const { return (int)body_a.size(); }
+
+	// Per interface, indexed as in GetActive()
+	std::vector<int>    body_a, body_b;		// indexes of the bodies, body_a < body_b
+	std::vector<int>    n_contacts;
+	std::vector<double> normal_force;		// sum of the normal reactions
+	std::vector<double> friction_force;		// norm of the resultant of the tangential reactions
+	std::vector<double> penetration;		// max penetration among the contacts
+	std::vector<double> slip_rate;			// tangential relative speed, weighted by the normal reactions
+
+	virtual bool ReportContactCallback(const chrono::ChVector<>& pA,
+									   const chrono::ChVector<>& pB,
+									   const chrono::ChMatrix33<>& plane_coord,
+									   const double& distance,
+									   const float& mfriction,
+									   const chrono::ChVector<>& react_forces,
+									   const chrono::ChVector<>& react_torques,
+									   chrono::collision::ChCollisionModel* modA,
+									   chrono::collision::ChCollisionModel* modB);
+
+private:
+	int GetInterface(int ia, int ib);
+
+	chrono::ChSystem* msystem;
+
+	std::vector<chrono::ChBody*> bodies;							// owned by the system
+	std::unordered_map<chrono::ChPhysicsItem*, int> body_index;
+	std::vector<int> pair_table;									// nbodies x nbodies, interface index or -1
+
+	std::vector<int> active;
+	std::vector<int> stamp;			// step of the last contact of each interface
+	int step;
+
+	// accumulators of the current step
+	std::vector<chrono::ChVector<> > friction_sum;
+	std::vector<double> slip_weight;
+	std::vector<double> slip_sum;
+};
+
+
+/// The contact container of Chrono, with the contacts it creates charged
+/// to MEMORY_CONTACTS of the memory account of the stepping thread.
+/// Set it with ChSystem::ChangeContactContainer() before any callback.
+
+class AccountedContactContainer : public chrono::ChContactContainer
+{
+public:
+	virtual void AddContact(const chrono::collision::ChCollisionInfo& mcontact);
+};
+
+
+#endif
@@ -0,0 +1,169 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cstdio>
+#include <algorithm>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#include <direct.h>
+	#include <process.h>
+	#include <sys/utime.h>
+#else
+	#include <dirent.h>
+	#include <unistd.h>
+	#include <utime.h>
+#endif
+
+#include "terremoto_files.h"
+
+
+// List the regular files and the subdirectories of a directory (names only).
+
+void list_directory(const std::string& dir, std::vector<std::string>& files, std::vector<std::string>& subdirs)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA fd;
+	HANDLE h = FindFirstFileA((dir + "\\*").c_str(), &fd);
+	if (h == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		std::string entry = fd.cFileName;
+		if (entry == "." || entry == "..")
+			continue;
+		if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			subdirs.push_back(entry);
+		else
+			files.push_back(entry);
+	}
+	while (FindNextFileA(h, &fd));
+	FindClose(h);
+#else
+	DIR* d = opendir(dir.c_str());
+	if (!d)
+		return;
+	while (struct dirent* de = readdir(d))
+	{
+		std::string entry = de->d_name;
+		if (entry == "." || entry == "..")
+			continue;
+		struct stat st;
+		if (stat((dir + "/" + entry).c_str(), &st) != 0)
+			continue;
+		if (S_ISDIR(st.st_mode))
+			subdirs.push_back(entry);
+		else
+			files.push_back(entry);
+	}
+	closedir(d);
+#endif
+	std::sort(files.begin(), files.end());
+	std::sort(subdirs.begin(), subdirs.end());
+}
+
+long file_mtime(const std::string& filename)
+{
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0)
+		return -1;
+	return (long)st.st_mtime;
+}
+
+long long file_size(const std::string& filename)
+{
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0)
+		return -1;
+	return (long long)st.st_size;
+}
+
+std::string join_path(const std::string& dir, const std::string& file)
+{
+	if (dir.empty())
+		return file;
+	char last = dir[dir.size() - 1];
+	if (last == '/' || last == '\\')
+		return dir + file;
+	return dir + "/" + file;
+}
+
+bool make_directory(const std::string& dir)
+{
+#ifdef _WIN32
+	if (_mkdir(dir.c_str()) == 0)
+		return true;
+#else
+	if (mkdir(dir.c_str(), 0777) == 0)
+		return true;
+#endif
+	struct stat st;
+	return stat(dir.c_str(), &st) == 0 && (st.st_mode & S_IFDIR);
+}
+
+bool create_exclusive(const std::string& filename, const std::string& content)
+{
+	// "x": fail if the file exists (O_CREAT | O_EXCL)
+	FILE* f = fopen(filename.c_str(), "wx");
+	if (!f)
+		return false;
+	fwrite(content.data(), 1, content.size(), f);
+	fclose(f);
+	return true;
+}
+
+bool write_replace(const std::string& filename, const std::string& content)
+{
+	std::string tmpname = filename + "." + host_process_id() + ".tmp";
+	FILE* f = fopen(tmpname.c_str(), "w");
+	if (!f)
+		return false;
+	bool ok = fwrite(content.data(), 1, content.size(), f) == content.size();
+	ok = (fclose(f) == 0) && ok;
+#ifdef _WIN32
+	ok = ok && MoveFileExA(tmpname.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+	ok = ok && rename(tmpname.c_str(), filename.c_str()) == 0;
+#endif
+	if (!ok)
+		remove(tmpname.c_str());
+	return ok;
+}
+
+bool touch_file(const std::string& filename)
+{
+#ifdef _WIN32
+	return _utime(filename.c_str(), 0) == 0;
+#else
+	return utime(filename.c_str(), 0) == 0;
+#endif
+}
+
+std::string host_process_id()
+{
+	char host[256] = "localhost";
+	char buf[300];
+#ifdef _WIN32
+	DWORD size = sizeof(host);
+	GetComputerNameA(host, &size);
+	sprintf(buf, "%s.%d", host, (int)_getpid());
+#else
+	gethostname(host, sizeof(host) - 1);
+	host[sizeof(host) - 1] = '\0';
+	sprintf(buf, "%s.%d", host, (int)getpid());
+#endif
+	return buf;
+}
@@ -0,0 +1,56 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_FILES_H
+#define TERREMOTO_FILES_H
+
+///////////////////////////////////////////////////
+//
+//   Small portable file-system utilities, used by
+//   the record library and the work queue.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+
+	// List the regular files and the subdirectories of a directory (names only, sorted).
+void list_directory(const std::string& dir, std::vector<std::string>& files, std::vector<std::string>& subdirs);
+
+	// Modification time of a file, or -1 if it does not exist.
+long file_mtime(const std::string& filename);
+
+	// Size of a file in bytes, or -1 if it does not exist.
+long long file_size(const std::string& filename);
+
+	// dir/file, without doubling the separator ("" dir gives file).
+std::string join_path(const std::string& dir, const std::string& file);
+
+	// Create a directory; returns true also if it exists already.
+bool make_directory(const std::string& dir);
+
+	// Create a file only if it does not exist, atomically (also across
+	// processes), with the given content. Returns false if it exists.
+bool create_exclusive(const std::string& filename, const std::string& content);
+
+	// Write a file aside, then rename it in place, so that readers see
+	// either the old or the new content.
+bool write_replace(const std::string& filename, const std::string& content);
+
+	// Set the modification time of an existing file to now.
+bool touch_file(const std::string& filename);
+
+	// Name of this machine and id of this process, as "host.pid".
+std::string host_process_id();
+
+
+#endif
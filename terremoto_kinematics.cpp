@@ -0,0 +1,117 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include "terremoto_kinematics.h"
+
+using namespace chrono;
+
+
+void RelativeKinematics::SetReference(ChSharedPtr<ChBody> mreference)
+{
+	reference = mreference.get_ptr();
+}
+
+int RelativeKinematics::AddBody(ChSharedPtr<ChBody> body)
+{
+	bodies.push_back(body.get_ptr());
+
+	size_t n = bodies.size();
+	std::vector<double>* buffers[] = {
+		&pos_x, &pos_y, &pos_z, &vel_x, &vel_y, &vel_z, &acc_x, &acc_y, &acc_z,
+		&rot_e0, &rot_e1, &rot_e2, &rot_e3, &abs_acc_x, &abs_acc_y, &abs_acc_z,
+		&abs_pos_x, &abs_pos_y, &abs_pos_z, &abs_vel_x, &abs_vel_y, &abs_vel_z,
+		&abs_rot_e0, &abs_rot_e1, &abs_rot_e2, &abs_rot_e3 };
+	for (size_t k = 0; k < sizeof(buffers) / sizeof(buffers[0]); ++k)
+		buffers[k]->resize(n, 0.0);
+
+	return (int)n - 1;
+}
+
+void RelativeKinematics::Update()
+{
+	int n = (int)bodies.size();
+	if (n == 0 || !reference)
+		return;
+
+	// 1) gather the absolute state of all bodies
+
+	for (int i = 0; i < n; ++i)
+	{
+		const ChBody* b = bodies[i];
+		const ChVector<>& p = b->GetPos();
+		const ChVector<>& v = b->GetPos_dt();
+		const ChVector<>& a = b->GetPos_dtdt();
+		const ChQuaternion<>& q = b->GetRot();
+		abs_pos_x[i] = p.x;  abs_pos_y[i] = p.y;  abs_pos_z[i] = p.z;
+		abs_vel_x[i] = v.x;  abs_vel_y[i] = v.y;  abs_vel_z[i] = v.z;
+		abs_acc_x[i] = a.x;  abs_acc_y[i] = a.y;  abs_acc_z[i] = a.z;
+		abs_rot_e0[i] = q.e0; abs_rot_e1[i] = q.e1; abs_rot_e2[i] = q.e2; abs_rot_e3[i] = q.e3;
+	}
+
+	// 2) state of the reference frame
+
+	ChVector<> pt = reference->GetPos();
+	ChVector<> vt = reference->GetPos_dt();
+	ChVector<> at = reference->GetPos_dtdt();
+	ChVector<> w  = reference->GetWvel_par();
+	ChVector<> wa = reference->GetWacc_par();
+	ChQuaternion<> qt = reference->GetRot();
+
+	// rotation matrix of the reference
+	double A00 = 1 - 2*(qt.e2*qt.e2 + qt.e3*qt.e3), A01 = 2*(qt.e1*qt.e2 - qt.e0*qt.e3), A02 = 2*(qt.e1*qt.e3 + qt.e0*qt.e2);
+	double A10 = 2*(qt.e1*qt.e2 + qt.e0*qt.e3), A11 = 1 - 2*(qt.e1*qt.e1 + qt.e3*qt.e3), A12 = 2*(qt.e2*qt.e3 - qt.e0*qt.e1);
+	double A20 = 2*(qt.e1*qt.e3 - qt.e0*qt.e2), A21 = 2*(qt.e2*qt.e3 + qt.e0*qt.e1), A22 = 1 - 2*(qt.e1*qt.e1 + qt.e2*qt.e2);
+
+	// 3) transform, as TransformParentToLocal() for moving frames:
+	//      r     = p - pt
+	//      v_rel = v - vt - w x r
+	//      a_rel = a - at - wa x r - w x (w x r) - 2 w x v_rel
+	//    expressed in the reference frame, and q_rel = qt' * q
+
+	for (int i = 0; i < n; ++i)
+	{
+		double rx = abs_pos_x[i] - pt.x;
+		double ry = abs_pos_y[i] - pt.y;
+		double rz = abs_pos_z[i] - pt.z;
+
+		double wrx = w.y*rz - w.z*ry;
+		double wry = w.z*rx - w.x*rz;
+		double wrz = w.x*ry - w.y*rx;
+
+		double vx = abs_vel_x[i] - vt.x - wrx;
+		double vy = abs_vel_y[i] - vt.y - wry;
+		double vz = abs_vel_z[i] - vt.z - wrz;
+
+		double ax = abs_acc_x[i] - at.x - (wa.y*rz - wa.z*ry) - (w.y*wrz - w.z*wry) - 2*(w.y*vz - w.z*vy);
+		double ay = abs_acc_y[i] - at.y - (wa.z*rx - wa.x*rz) - (w.z*wrx - w.x*wrz) - 2*(w.z*vx - w.x*vz);
+		double az = abs_acc_z[i] - at.z - (wa.x*ry - wa.y*rx) - (w.x*wry - w.y*wrx) - 2*(w.x*vy - w.y*vx);
+
+		pos_x[i] = A00*rx + A10*ry + A20*rz;
+		pos_y[i] = A01*rx + A11*ry + A21*rz;
+		pos_z[i] = A02*rx + A12*ry + A22*rz;
+		vel_x[i] = A00*vx + A10*vy + A20*vz;
+		vel_y[i] = A01*vx + A11*vy + A21*vz;
+		vel_z[i] = A02*vx + A12*vy + A22*vz;
+		acc_x[i] = A00*ax + A10*ay + A20*az;
+		acc_y[i] = A01*ax + A11*ay + A21*az;
+		acc_z[i] = A02*ax + A12*ay + A22*az;
+	}
+
+	double c0 = qt.e0, c1 = -qt.e1, c2 = -qt.e2, c3 = -qt.e3;
+	for (int i = 0; i < n; ++i)
+	{
+		double q0 = abs_rot_e0[i], q1 = abs_rot_e1[i], q2 = abs_rot_e2[i], q3 = abs_rot_e3[i];
+		rot_e0[i] = c0*q0 - c1*q1 - c2*q2 - c3*q3;
+		rot_e1[i] = c0*q1 + c1*q0 + c2*q3 - c3*q2;
+		rot_e2[i] = c0*q2 - c1*q3 + c2*q0 + c3*q1;
+		rot_e3[i] = c0*q3 + c1*q2 - c2*q1 + c3*q0;
+	}
+}
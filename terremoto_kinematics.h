@@ -0,0 +1,80 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_KINEMATICS_H
+#define TERREMOTO_KINEMATICS_H
+
+///////////////////////////////////////////////////
+//
+//   Batched extraction of the kinematics of many
+//   bodies relative to a reference body (the
+//   shaking table), in structure-of-arrays buffers.
+//
+///////////////////////////////////////////////////
+
+#include <vector>
+
+#include "physics/ChBody.h"
+
+
+/// Position, speed, acceleration and rotation of a set of bodies relative
+/// to a reference body, expressed in the reference frame, as with
+/// ChFrameMoving::TransformParentToLocal() but for all bodies at once.
+///
+/// Update() first gathers the absolute state of all bodies into contiguous
+/// arrays (one pass over the body pointers), then transforms them in
+/// plain loops over the arrays, which the compiler can vectorize.
+/// Loggers and metrics then read the public arrays, indexed as the
+/// bodies were added.
+
+class RelativeKinematics
+{
+public:
+	RelativeKinematics() : reference(0) {}
+
+		/// Set the body whose frame is the reference (ex. the table).
+	void SetReference(chrono::ChSharedPtr<chrono::ChBody> mreference);
+
+		/// Add a body to monitor; returns its index in the buffers.
+	int AddBody(chrono::ChSharedPtr<chrono::ChBody> body);
+
+	int GetNbodies() const { return (int)bodies.size(); }
+
+		/// Gather and transform the current state of all bodies.
+	void Update();
+
+	chrono::ChVector<> GetPos(int i)     const { return chrono::ChVector<>(pos_x[i], pos_y[i], pos_z[i]); }
+	chrono::ChVector<> GetPos_dt(int i)   const { return chrono::ChVector<>(vel_x[i], vel_y[i], vel_z[i]); }
+	chrono::ChVector<> GetPos_dtdt(int i) const { return chrono::ChVector<>(acc_x[i], acc_y[i], acc_z[i]); }
+	chrono::ChQuaternion<> GetRot(int i)  const { return chrono::ChQuaternion<>(rot_e0[i], rot_e1[i], rot_e2[i], rot_e3[i]); }
+	chrono::ChVector<> GetAbsPos_dtdt(int i) const { return chrono::ChVector<>(abs_acc_x[i], abs_acc_y[i], abs_acc_z[i]); }
+
+	// Relative kinematics, in the reference frame
+	std::vector<double> pos_x, pos_y, pos_z;
+	std::vector<double> vel_x, vel_y, vel_z;
+	std::vector<double> acc_x, acc_y, acc_z;
+	std::vector<double> rot_e0, rot_e1, rot_e2, rot_e3;
+
+	// Absolute accelerations, as gathered
+	std::vector<double> abs_acc_x, abs_acc_y, abs_acc_z;
+
+private:
+	chrono::ChBody* reference;
+	std::vector<chrono::ChBody*> bodies;	// owned by their ChSystem
+
+	// Absolute state, as gathered
+	std::vector<double> abs_pos_x, abs_pos_y, abs_pos_z;
+	std::vector<double> abs_vel_x, abs_vel_y, abs_vel_z;
+	std::vector<double> abs_rot_e0, abs_rot_e1, abs_rot_e2, abs_rot_e3;
+};
+
+
+#endif
@@ -0,0 +1,135 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <sstream>
+#include <algorithm>
+
+#include "terremoto_materials.h"
+
+using namespace chrono;
+
+
+static const char* material_names[MATERIAL_NIDS] = { "concrete", "table", "marble", "brick" };
+
+
+bool parse_material_pair(const std::string& text, MaterialPair& pair)
+{
+	std::istringstream in(text);
+	std::string name_a, name_b;
+	MaterialParams params;
+	if (!(in >> name_a >> name_b >> params.friction >> params.compliance >> params.dampingf))
+		return false;
+	int id_a = MaterialTable::FindName(name_a);
+	int id_b = MaterialTable::FindName(name_b);
+	if (id_a < 0 || id_b < 0)
+		return false;
+	pair = MaterialPair(id_a, id_b, params);
+	return true;
+}
+
+std::string format_material_pair(const MaterialPair& pair)
+{
+	std::ostringstream out;
+	out.precision(17);
+	out << MaterialTable::GetName(pair.id_a) << " " << MaterialTable::GetName(pair.id_b) << " "
+		<< pair.params.friction << " " << pair.params.compliance << " " << pair.params.dampingf;
+	return out.str();
+}
+
+
+
+MaterialTable::MaterialTable(const MaterialParams& drums)
+{
+	// ChMaterialSurface defaults, for the bodies that had no material of their own
+	materials[MATERIAL_CONCRETE] = MaterialParams(0.6, 0, 0);
+	materials[MATERIAL_TABLE]    = MaterialParams(0.6, 0, 0);
+	materials[MATERIAL_MARBLE]   = drums;
+	materials[MATERIAL_BRICK]    = drums;
+
+	for (int i = 0; i < MATERIAL_NIDS * MATERIAL_NIDS; ++i)
+		pair_set[i] = false;
+	for (int a = 0; a < MATERIAL_NIDS; ++a)
+		for (int b = 0; b < MATERIAL_NIDS; ++b)
+			Combine(a, b);
+}
+
+void MaterialTable::Combine(int id_a, int id_b)
+{
+	// As Chrono combines two surfaces: the lower friction and damping,
+	// the sum of the compliances.
+	const MaterialParams& ma = materials[id_a];
+	const MaterialParams& mb = materials[id_b];
+	ChMaterialCouple& c = couples[id_a * MATERIAL_NIDS + id_b];
+	c.static_friction   = (float)std::min(ma.friction, mb.friction);
+	c.sliding_friction  = c.static_friction;
+	c.rolling_friction  = 0;
+	c.spinning_friction = 0;
+	c.restitution       = 0;
+	c.cohesion          = 0;
+	c.dampingf          = (float)std::min(ma.dampingf, mb.dampingf);
+	c.compliance        = (float)(ma.compliance + mb.compliance);
+	c.complianceT       = 0;
+	c.complianceRoll    = 0;
+	c.complianceSpin    = 0;
+}
+
+void MaterialTable::SetMaterial(int id, const MaterialParams& params)
+{
+	materials[id] = params;
+	for (int other = 0; other < MATERIAL_NIDS; ++other)
+	{
+		if (!pair_set[id * MATERIAL_NIDS + other])
+			Combine(id, other);
+		if (!pair_set[other * MATERIAL_NIDS + id])
+			Combine(other, id);
+	}
+}
+
+void MaterialTable::SetPair(const MaterialPair& pair)
+{
+	for (int k = 0; k < 2; ++k)
+	{
+		int index = (k == 0) ? pair.id_a * MATERIAL_NIDS + pair.id_b : pair.id_b * MATERIAL_NIDS + pair.id_a;
+		ChMaterialCouple& c = couples[index];
+		c.static_friction  = (float)pair.params.friction;
+		c.sliding_friction = (float)pair.params.friction;
+		c.compliance       = (float)pair.params.compliance;
+		c.dampingf         = (float)pair.params.dampingf;
+		pair_set[index] = true;
+	}
+}
+
+MaterialParams MaterialTable::GetPair(int id_a, int id_b) const
+{
+	const ChMaterialCouple& c = couples[id_a * MATERIAL_NIDS + id_b];
+	return MaterialParams(c.sliding_friction, c.compliance, c.dampingf);
+}
+
+const char* MaterialTable::GetName(int id)
+{
+	return (id >= 0 && id < MATERIAL_NIDS) ? material_names[id] : "unknown";
+}
+
+int MaterialTable::FindName(const std::string& name)
+{
+	for (int id = 0; id < MATERIAL_NIDS; ++id)
+		if (name == material_names[id])
+			return id;
+	return -1;
+}
+
+void MaterialTable::ContactCallback(const collision::ChCollisionInfo& mcontactinfo, ChMaterialCouple& material)
+{
+	unsigned int id_a = (unsigned int)mcontactinfo.modelA->GetPhysicsItem()->GetIdentifier();
+	unsigned int id_b = (unsigned int)mcontactinfo.modelB->GetPhysicsItem()->GetIdentifier();
+	if (id_a < MATERIAL_NIDS && id_b < MATERIAL_NIDS)
+		material = couples[id_a * MATERIAL_NIDS + id_b];
+}
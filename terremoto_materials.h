@@ -0,0 +1,113 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_MATERIALS_H
+#define TERREMOTO_MATERIALS_H
+
+///////////////////////////////////////////////////
+//
+//   Materials of the temple bodies, and the contact
+//   parameters of each pair of materials, computed
+//   once in a dense table that the contact callback
+//   of the system indexes by the material IDs of
+//   the two bodies.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+
+#include "physics/ChMaterialCouple.h"
+#include "physics/ChContactContainerBase.h"
+
+
+/// Contact parameters of the material shared by columns etc.
+
+class MaterialParams
+{
+public:
+	MaterialParams() : friction(0.6), compliance(0.00000002), dampingf(1.5) {}
+	MaterialParams(double mfriction, double mcompliance, double mdampingf) : friction(mfriction), compliance(mcompliance), dampingf(mdampingf) {}
+
+	double friction;
+	double compliance;
+	double dampingf;
+};
+
+
+/// Material IDs, stored as the identifier of each body.
+
+enum MaterialId
+{
+	MATERIAL_CONCRETE = 0,	// floor, pedestals, capitals, beams
+	MATERIAL_TABLE,			// the shaking table
+	MATERIAL_MARBLE,		// drums of create_column()
+	MATERIAL_BRICK,			// drums of create_brickcolumn()
+	MATERIAL_NIDS
+};
+
+
+/// Parameters of the contact between two materials, instead of the
+/// combination of their surfaces. The compliance is of the contact,
+/// as in ChMaterialCouple (not of each surface).
+
+class MaterialPair
+{
+public:
+	MaterialPair() : id_a(MATERIAL_CONCRETE), id_b(MATERIAL_CONCRETE) {}
+	MaterialPair(int mid_a, int mid_b, const MaterialParams& mparams) : id_a(mid_a), id_b(mid_b), params(mparams) {}
+
+	int id_a;
+	int id_b;
+	MaterialParams params;
+};
+
+	// Parse/format a pair as  "<material> <material> friction compliance dampingf",
+	// ex. "marble brick 0.5 4e-8 1.5". Returns false on unknown names or missing values.
+bool parse_material_pair(const std::string& text, MaterialPair& pair);
+std::string format_material_pair(const MaterialPair& pair);
+
+
+/// The materials of a model and the contact parameters of all their pairs.
+/// Once set as the add-contact callback of a system, each new contact
+/// gets the parameters of its pair with one table lookup.
+
+class MaterialTable : public chrono::ChAddContactCallback
+{
+public:
+		/// The drums (marble and brick) of the given material, the table and
+		/// the concrete boxes with the default surface of Chrono: the same
+		/// contacts as when all the drums share one material.
+	MaterialTable(const MaterialParams& drums = MaterialParams());
+
+		/// Surface of a material: its pairs, except those set with SetPair(),
+		/// combine it with the other surfaces.
+	void SetMaterial(int id, const MaterialParams& params);
+	const MaterialParams& GetMaterial(int id) const { return materials[id]; }
+
+		/// Contact parameters of a pair, in both orders.
+	void SetPair(const MaterialPair& pair);
+	MaterialParams GetPair(int id_a, int id_b) const;
+
+	static const char* GetName(int id);
+	static int FindName(const std::string& name);	// -1 if unknown
+
+	virtual void ContactCallback(const chrono::collision::ChCollisionInfo& mcontactinfo, chrono::ChMaterialCouple& material);
+
+private:
+	void Combine(int id_a, int id_b);
+
+	MaterialParams materials[MATERIAL_NIDS];
+	bool pair_set[MATERIAL_NIDS * MATERIAL_NIDS];
+	chrono::ChMaterialCouple couples[MATERIAL_NIDS * MATERIAL_NIDS];
+};
+
+
+#endif
@@ -0,0 +1,362 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+#include "terremoto_memory.h"
+
+
+#ifdef TERREMOTO_MEMORY_ACCOUNTING
+
+// Nothing here may allocate with operator new, which would recurse:
+// the account table is static, and the arena blocks come from malloc.
+
+static const int max_accounts = 256;				// open at the same time; slot 0 is "no account"
+static const size_t arena_block_size = 1 << 20;
+static const size_t arena_max_object = 1 << 14;		// larger objects go to malloc
+
+
+struct MemorySlot
+{
+	std::atomic<bool> in_use;
+	std::atomic<unsigned int> generation;	// of the account in the slot
+	std::atomic<long long> bytes[MEMORY_NCATEGORIES];
+	std::atomic<long long> total;
+	std::atomic<long long> peak;
+
+	std::atomic_flag arena_lock;
+	char* arena_blocks;				// last block; each block begins with a pointer to the previous one
+	char* arena_next;
+	size_t arena_left;
+	std::atomic<long long> arena_reserved;
+	std::atomic<long long> arena_live;
+};
+
+// Static storage: zero-initialized before any allocation can happen.
+static MemorySlot slots[max_accounts];
+
+
+// Prepended to every allocation; 16 bytes, so that the alignment of
+// malloc is kept. The generation tells the allocations of a closed
+// account from those of the next account in its slot.
+struct AllocationHeader
+{
+	unsigned long long size;
+	unsigned short slot;
+	unsigned short generation;
+	unsigned short category;
+	unsigned short arena;
+};
+
+struct ThreadScope
+{
+	int slot;
+	int category;
+	bool arena;
+};
+
+static thread_local ThreadScope current_scope = { 0, MEMORY_OTHER, false };
+
+
+static void* arena_allocate(MemorySlot& s, size_t size)
+{
+	size = (size + 15) & ~(size_t)15;
+
+	while (s.arena_lock.test_and_set(std::memory_order_acquire))
+		;
+	if (s.arena_left < size)
+	{
+		char* block = (char*)malloc(arena_block_size);
+		if (!block)
+		{
+			s.arena_lock.clear(std::memory_order_release);
+			return 0;
+		}
+		*(char**)block = s.arena_blocks;
+		s.arena_blocks = block;
+		s.arena_next = block + 16;
+		s.arena_left = arena_block_size - 16;
+		s.arena_reserved += arena_block_size;
+	}
+	void* p = s.arena_next;
+	s.arena_next += size;
+	s.arena_left -= size;
+	s.arena_lock.clear(std::memory_order_release);
+	return p;
+}
+
+static void* accounted_new(size_t size)
+{
+	const ThreadScope scope = current_scope;
+	size_t total = size + sizeof(AllocationHeader);
+
+	AllocationHeader* h = 0;
+	bool arena = false;
+	if (scope.slot && scope.arena && size <= arena_max_object)
+	{
+		h = (AllocationHeader*)arena_allocate(slots[scope.slot], total);
+		arena = (h != 0);
+	}
+	if (!h)
+		h = (AllocationHeader*)malloc(total);
+	if (!h)
+		return 0;
+
+	h->size = size;
+	h->slot = (unsigned short)scope.slot;
+	h->generation = scope.slot ? (unsigned short)slots[scope.slot].generation.load(std::memory_order_relaxed) : 0;
+	h->category = (unsigned short)scope.category;
+	h->arena = arena ? 1 : 0;
+
+	if (scope.slot)
+	{
+		MemorySlot& s = slots[scope.slot];
+		s.bytes[scope.category].fetch_add((long long)size, std::memory_order_relaxed);
+		long long now = s.total.fetch_add((long long)size, std::memory_order_relaxed) + (long long)size;
+		long long peak = s.peak.load(std::memory_order_relaxed);
+		while (now > peak && !s.peak.compare_exchange_weak(peak, now, std::memory_order_relaxed))
+			;
+		if (arena)
+			s.arena_live.fetch_add((long long)size, std::memory_order_relaxed);
+	}
+	return h + 1;
+}
+
+static void accounted_delete(void* p)
+{
+	if (!p)
+		return;
+	AllocationHeader* h = (AllocationHeader*)p - 1;
+	if (h->slot)
+	{
+		// an allocation that outlived its account is no longer counted
+		MemorySlot& s = slots[h->slot];
+		if (h->generation == (unsigned short)s.generation.load(std::memory_order_relaxed))
+		{
+			s.bytes[h->category].fetch_sub((long long)h->size, std::memory_order_relaxed);
+			s.total.fetch_sub((long long)h->size, std::memory_order_relaxed);
+			if (h->arena)
+				s.arena_live.fetch_sub((long long)h->size, std::memory_order_relaxed);
+		}
+		// the arena block stays reserved until the account is closed (or
+		// for ever, if the account was closed with objects in it)
+		if (h->arena)
+			return;
+	}
+	free(h);
+}
+
+
+void* operator new(size_t size)
+{
+	void* p = accounted_new(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	void* p = accounted_new(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return accounted_new(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return accounted_new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	accounted_delete(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	accounted_delete(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	accounted_delete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	accounted_delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	accounted_delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	accounted_delete(p);
+}
+
+
+
+MemoryAccount::MemoryAccount(const std::string& mlabel)
+	: label(mlabel),
+	  slot(0)
+{
+	for (int i = 1; i < max_accounts; ++i)
+	{
+		MemorySlot& s = slots[i];
+		bool free_slot = false;
+		if (!s.in_use.compare_exchange_strong(free_slot, true))
+			continue;
+		// a new generation, so that the frees of the allocations that
+		// outlived the previous account of the slot are not charged to this one
+		++s.generation;
+		for (int c = 0; c < MEMORY_NCATEGORIES; ++c)
+			s.bytes[c] = 0;
+		s.total = 0;
+		s.peak = 0;
+		s.arena_blocks = 0;
+		s.arena_next = 0;
+		s.arena_left = 0;
+		s.arena_reserved = 0;
+		s.arena_live = 0;
+		slot = i;
+		return;
+	}
+	fprintf(stderr, "Memory accounting: more than %d accounts open at once, %s not accounted\n", max_accounts - 1, label.c_str());
+}
+
+MemoryAccount::~MemoryAccount()
+{
+	if (!slot)
+		return;
+	MemorySlot& s = slots[slot];
+
+	// Objects still alive in the arena keep all its blocks: release them only
+	// if the instance was torn down completely (the usual case, when the
+	// account is declared before the ChSystem). Otherwise the blocks are
+	// left to those objects, and the slot is reused anyway.
+	if (s.arena_live == 0)
+	{
+		while (s.arena_blocks)
+		{
+			char* previous = *(char**)s.arena_blocks;
+			free(s.arena_blocks);
+			s.arena_blocks = previous;
+		}
+	}
+	else
+		fprintf(stderr, "Memory accounting: %lld bytes still live in the arena of %s, %lld bytes of arena kept\n",
+				(long long)s.arena_live, label.c_str(), (long long)s.arena_reserved);
+
+	s.in_use = false;
+}
+
+bool MemoryAccount::IsEnabled()
+{
+	return true;
+}
+
+long long MemoryAccount::GetBytes(MemoryCategory category) const
+{
+	return slot ? slots[slot].bytes[category].load() : 0;
+}
+
+long long MemoryAccount::GetTotalBytes() const
+{
+	return slot ? slots[slot].total.load() : 0;
+}
+
+long long MemoryAccount::GetPeakBytes() const
+{
+	return slot ? slots[slot].peak.load() : 0;
+}
+
+long long MemoryAccount::GetArenaBytes() const
+{
+	return slot ? slots[slot].arena_reserved.load() : 0;
+}
+
+
+
+MemoryScope::MemoryScope(MemoryAccount* account, MemoryCategory category, bool arena)
+	: previous_slot(current_scope.slot),
+	  previous_category(current_scope.category),
+	  previous_arena(current_scope.arena)
+{
+	current_scope.slot = account ? account->slot : 0;
+	current_scope.category = category;
+	current_scope.arena = account && account->slot && arena;
+}
+
+MemoryScope::MemoryScope(MemoryCategory category)
+	: previous_slot(current_scope.slot),
+	  previous_category(current_scope.category),
+	  previous_arena(current_scope.arena)
+{
+	current_scope.category = category;
+}
+
+MemoryScope::~MemoryScope()
+{
+	current_scope.slot = previous_slot;
+	current_scope.category = previous_category;
+	current_scope.arena = previous_arena;
+}
+
+
+#else
+
+// Without accounting, accounts and scopes do nothing.
+
+MemoryAccount::MemoryAccount(const std::string& mlabel) : label(mlabel), slot(0) {}
+MemoryAccount::~MemoryAccount() {}
+bool MemoryAccount::IsEnabled() { return false; }
+long long MemoryAccount::GetBytes(MemoryCategory) const { return 0; }
+long long MemoryAccount::GetTotalBytes() const { return 0; }
+long long MemoryAccount::GetPeakBytes() const { return 0; }
+long long MemoryAccount::GetArenaBytes() const { return 0; }
+
+MemoryScope::MemoryScope(MemoryAccount*, MemoryCategory, bool) : previous_slot(0), previous_category(0), previous_arena(false) {}
+MemoryScope::MemoryScope(MemoryCategory) : previous_slot(0), previous_category(0), previous_arena(false) {}
+MemoryScope::~MemoryScope() {}
+
+#endif
+
+
+
+void MemoryAccount::WriteHeader(std::ostream& out)
+{
+	out << "# label  bodies  records  contacts  simulation  other  total  peak  arena  (bytes)\n";
+}
+
+void MemoryAccount::WriteRecord(std::ostream& out) const
+{
+	out << label << " "
+		<< GetBytes(MEMORY_BODIES) << " "
+		<< GetBytes(MEMORY_RECORDS) << " "
+		<< GetBytes(MEMORY_CONTACTS) << " "
+		<< GetBytes(MEMORY_SIMULATION) << " "
+		<< GetBytes(MEMORY_OTHER) << " "
+		<< GetTotalBytes() << " "
+		<< GetPeakBytes() << " "
+		<< GetArenaBytes() << "\n";
+}
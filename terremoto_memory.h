@@ -0,0 +1,107 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_MEMORY_H
+#define TERREMOTO_MEMORY_H
+
+///////////////////////////////////////////////////
+//
+//   Heap memory of each simulation instance.
+//
+//   With TERREMOTO_MEMORY_ACCOUNTING defined (see
+//   CMakeLists.txt) the global operator new is
+//   replaced: each allocation is charged to the
+//   account and category in scope on its thread,
+//   and allocations in an arena scope are carved
+//   from large blocks owned by the account, which
+//   avoids the fragmentation of many small blocks
+//   when many instances are built side by side.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <iostream>
+
+
+enum MemoryCategory
+{
+	MEMORY_OTHER = 0,
+	MEMORY_BODIES,		// bodies, with their collision models and assets
+	MEMORY_RECORDS,		// motion functions and record samples
+	MEMORY_CONTACTS,	// contacts of the contact container, and their reduction per interface
+	MEMORY_SIMULATION,	// allocated while stepping, besides the contacts: collision pairs, solver
+	MEMORY_NCATEGORIES
+};
+
+
+/// The memory of one simulation instance. Declare it before the ChSystem
+/// of the instance, so that it outlives everything charged to it.
+/// Up to 255 accounts can be open at once; a closed account frees its
+/// slot for the next one, and what outlives it is no longer counted.
+
+class MemoryAccount
+{
+public:
+	MemoryAccount(const std::string& mlabel);
+
+		/// Releases the arena, unless something still lives in it.
+	~MemoryAccount();
+
+		/// False if the build has no memory accounting: all sizes are 0.
+	static bool IsEnabled();
+
+		/// Bytes currently allocated in a category
+	long long GetBytes(MemoryCategory category) const;
+
+		/// Bytes currently allocated, all categories, and their peak
+	long long GetTotalBytes() const;
+	long long GetPeakBytes() const;
+
+		/// Bytes of the blocks reserved by the arena (freed objects in the
+		/// arena are not reused, so this can exceed the allocated bytes).
+	long long GetArenaBytes() const;
+
+		/// Write a one-line record   label  bodies  records  contacts  simulation  other  total  peak  arena  (bytes)
+	void WriteRecord(std::ostream& out) const;
+	static void WriteHeader(std::ostream& out);
+
+	const std::string& GetLabel() const { return label; }
+
+private:
+	friend class MemoryScope;
+
+	std::string label;
+	int slot;		// 0 if not accounted
+};
+
+
+/// While in scope, the allocations of this thread are charged to the account
+/// in the given category, and taken from its arena if 'arena' is true.
+/// Scopes nest; a null account suspends the accounting.
+
+class MemoryScope
+{
+public:
+	MemoryScope(MemoryAccount* account, MemoryCategory category, bool arena = false);
+
+		/// Charge to another category the account of the enclosing scope,
+		/// for code that does not know the account (ex. Chrono callbacks).
+	explicit MemoryScope(MemoryCategory category);
+	~MemoryScope();
+
+private:
+	int previous_slot;
+	int previous_category;
+	bool previous_arena;
+};
+
+
+#endif
@@ -0,0 +1,183 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cmath>
+#include <algorithm>
+
+#include "core/ChMath.h"
+
+#include "terremoto_metrics.h"
+
+using namespace chrono;
+
+
+static void peak_abs(ChVector<>& peak, const ChVector<>& v)
+{
+	peak.x = std::max(peak.x, fabs(v.x));
+	peak.y = std::max(peak.y, fabs(v.y));
+	peak.z = std::max(peak.z, fabs(v.z));
+}
+
+static double norm(const ChVector<>& v)
+{
+	return sqrt(v.x*v.x + v.y*v.y + v.z*v.z);
+}
+
+
+void KinematicsPeaks::Reset()
+{
+	peak_disp = ChVector<>(0,0,0);
+	peak_vel  = ChVector<>(0,0,0);
+	peak_acc  = ChVector<>(0,0,0);
+	peak_disp_norm = 0;
+	peak_vel_norm  = 0;
+	peak_acc_norm  = 0;
+	residual_disp = ChVector<>(0,0,0);
+}
+
+void KinematicsPeaks::Update(const ChVector<>& rel_disp,
+							 const ChVector<>& rel_vel,
+							 const ChVector<>& rel_acc)
+{
+	peak_abs(peak_disp, rel_disp);
+	peak_abs(peak_vel,  rel_vel);
+	peak_abs(peak_acc,  rel_acc);
+	peak_disp_norm = std::max(peak_disp_norm, norm(rel_disp));
+	peak_vel_norm  = std::max(peak_vel_norm,  norm(rel_vel));
+	peak_acc_norm  = std::max(peak_acc_norm,  norm(rel_acc));
+	residual_disp = rel_disp;
+}
+
+
+
+void AriasAccumulator::Reset()
+{
+	integral  = 0;
+	last_time = 0;
+	last_acc2 = 0;
+	started   = false;
+}
+
+void AriasAccumulator::Update(double time, double acc)
+{
+	double acc2 = acc*acc;
+	if (started && time > last_time)
+		integral += 0.5 * (acc2 + last_acc2) * (time - last_time);
+	last_time = time;
+	last_acc2 = acc2;
+	started   = true;
+}
+
+double AriasAccumulator::GetIntensity() const
+{
+	const double g = 9.81;
+	return integral * CH_C_PI / (2.0 * g);
+}
+
+
+
+ResponseMetrics::ResponseMetrics(int n_drums)
+{
+	Reset(n_drums);
+}
+
+void ResponseMetrics::Reset(int n_drums)
+{
+	brick_1.Reset();
+	brick_2.Reset();
+	drum_peak_tilt.assign(n_drums, 0.0);
+	arias_x.Reset();
+	arias_y.Reset();
+	arias_transverse.Reset();
+	peak_input_rotation = ChVector<>(0,0,0);
+}
+
+double ResponseMetrics::TiltAngle(const ChQuaternion<>& q)
+{
+	// Y component of the local Y axis rotated by q, that is the
+	// cosine of the angle between the drum axis and the table normal.
+	double cos_tilt = q.e0*q.e0 - q.e1*q.e1 + q.e2*q.e2 - q.e3*q.e3;
+	cos_tilt = std::min(1.0, std::max(-1.0, cos_tilt));
+	return acos(cos_tilt);
+}
+
+void ResponseMetrics::UpdateDrumTilt(int idrum, double tilt)
+{
+	drum_peak_tilt[idrum] = std::max(drum_peak_tilt[idrum], tilt);
+}
+
+void ResponseMetrics::UpdateInput(double time, double acc_x, double acc_y)
+{
+	arias_x.Update(time, acc_x);
+	arias_y.Update(time, acc_y);
+}
+
+void ResponseMetrics::UpdateInputComponents(double time, double acc_transverse, const ChVector<>& rotation)
+{
+	arias_transverse.Update(time, acc_transverse);
+	peak_abs(peak_input_rotation, rotation);
+}
+
+static void write_peaks_header(std::ostream& out, const char* name)
+{
+	out << " " << name << "_peak_dx " << name << "_peak_dy " << name << "_peak_dz " << name << "_peak_d"
+		<< " " << name << "_res_dx "  << name << "_res_dy "  << name << "_res_dz"
+		<< " " << name << "_peak_v " << name << "_peak_a";
+}
+
+static void write_peaks(std::ostream& out, const KinematicsPeaks& p)
+{
+	out << " " << p.peak_disp.x << " " << p.peak_disp.y << " " << p.peak_disp.z << " " << p.peak_disp_norm
+		<< " " << p.residual_disp.x << " " << p.residual_disp.y << " " << p.residual_disp.z
+		<< " " << p.peak_vel_norm << " " << p.peak_acc_norm;
+}
+
+void ResponseMetrics::WriteHeader(std::ostream& out) const
+{
+	out << "# case";
+	write_peaks_header(out, "brick_1");
+	write_peaks_header(out, "brick_2");
+	out << " arias_x arias_y arias_t peak_rx peak_ry peak_rz n_drums max_tilt max_tilt_drum mean_tilt\n";
+}
+
+void ResponseMetrics::WriteRecord(std::ostream& out, const std::string& case_label) const
+{
+	// Only statistics of the drum tilts, so that the columns do not depend
+	// on the temple, and runs of different temples share the table.
+	double max_tilt = 0;
+	double mean_tilt = 0;
+	int max_tilt_drum = -1;
+	for (size_t i = 0; i < drum_peak_tilt.size(); ++i)
+	{
+		if (max_tilt_drum < 0 || drum_peak_tilt[i] > max_tilt)
+		{
+			max_tilt = drum_peak_tilt[i];
+			max_tilt_drum = (int)i;
+		}
+		mean_tilt += drum_peak_tilt[i];
+	}
+	if (!drum_peak_tilt.empty())
+		mean_tilt /= (double)drum_peak_tilt.size();
+
+	out << case_label;
+	write_peaks(out, brick_1);
+	write_peaks(out, brick_2);
+	out << " " << arias_x.GetIntensity() << " " << arias_y.GetIntensity() << " " << arias_transverse.GetIntensity()
+		<< " " << peak_input_rotation.x << " " << peak_input_rotation.y << " " << peak_input_rotation.z
+		<< " " << drum_peak_tilt.size() << " " << max_tilt << " " << max_tilt_drum << " " << mean_tilt << "\n";
+}
+
+void ResponseMetrics::WriteDrumTilts(std::ostream& out) const
+{
+	out << "# drum  peak_tilt\n";
+	for (size_t i = 0; i < drum_peak_tilt.size(); ++i)
+		out << i << " " << drum_peak_tilt[i] << "\n";
+}
@@ -0,0 +1,131 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_METRICS_H
+#define TERREMOTO_METRICS_H
+
+///////////////////////////////////////////////////
+//
+//   Streaming accumulators of the scalar response
+//   quantities that a sweep needs from each run
+//   (peaks, residuals, tilts, Arias intensity), so
+//   that full time histories need not be dumped.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "core/ChVector.h"
+#include "core/ChQuaternion.h"
+
+
+/// Peak (max absolute value, per component and as a norm) and
+/// residual (last value) of the relative kinematics of one body.
+
+class KinematicsPeaks
+{
+public:
+	KinematicsPeaks() { Reset(); }
+
+	void Reset();
+
+		/// Feed the displacement, speed and acceleration of the body
+		/// relative to the table, at one time step.
+	void Update(const chrono::ChVector<>& rel_disp,
+				const chrono::ChVector<>& rel_vel,
+				const chrono::ChVector<>& rel_acc);
+
+	chrono::ChVector<> peak_disp;
+	chrono::ChVector<> peak_vel;
+	chrono::ChVector<> peak_acc;
+	double peak_disp_norm;
+	double peak_vel_norm;
+	double peak_acc_norm;
+	chrono::ChVector<> residual_disp;
+};
+
+
+/// Arias intensity  Ia = pi/(2g) * integral(a(t)^2 dt)  of an
+/// acceleration signal, integrated with the trapezoidal rule
+/// as samples arrive.
+
+class AriasAccumulator
+{
+public:
+	AriasAccumulator() { Reset(); }
+
+	void Reset();
+
+	void Update(double time, double acc);
+
+		/// Arias intensity, in m/s.
+	double GetIntensity() const;
+
+private:
+	double integral;
+	double last_time;
+	double last_acc2;
+	bool   started;
+};
+
+
+/// Collects all the streaming metrics of one run and writes them
+/// as a single summary record.
+
+class ResponseMetrics
+{
+public:
+	ResponseMetrics(int n_drums = 0);
+
+	void Reset(int n_drums);
+
+		/// Tilt of a drum, in radians, given the rotation of the drum
+		/// relative to the table: the angle between the drum axis (local Y)
+		/// and the table normal.
+	static double TiltAngle(const chrono::ChQuaternion<>& rel_rot);
+
+	void UpdateBrick1(const chrono::ChVector<>& rel_disp, const chrono::ChVector<>& rel_vel, const chrono::ChVector<>& rel_acc)
+		{ brick_1.Update(rel_disp, rel_vel, rel_acc); }
+	void UpdateBrick2(const chrono::ChVector<>& rel_disp, const chrono::ChVector<>& rel_vel, const chrono::ChVector<>& rel_acc)
+		{ brick_2.Update(rel_disp, rel_vel, rel_acc); }
+	void UpdateDrumTilt(int idrum, double tilt);
+	void UpdateInput(double time, double acc_x, double acc_y);
+
+		/// The other components of a combined record: the acceleration along
+		/// the X axis of the link (transverse), and the rotations, in rad.
+	void UpdateInputComponents(double time, double acc_transverse, const chrono::ChVector<>& rotation);
+
+		/// Write the column names of the summary record, as a '#' comment line.
+		/// The columns are the same for any temple and any record: the drum
+		/// tilts are summarized by their count, maximum (and its drum, -1 if
+		/// none) and mean, and the components that a record lacks are zero.
+	void WriteHeader(std::ostream& out) const;
+
+		/// Write one summary record (a single line) for this run,
+		/// prefixed by a free label that identifies the case.
+	void WriteRecord(std::ostream& out, const std::string& case_label) const;
+
+		/// Write the peak tilt of each drum, one line per drum.
+	void WriteDrumTilts(std::ostream& out) const;
+
+	KinematicsPeaks brick_1;
+	KinematicsPeaks brick_2;
+	std::vector<double> drum_peak_tilt;
+	AriasAccumulator arias_x;
+	AriasAccumulator arias_y;
+	AriasAccumulator arias_transverse;
+	chrono::ChVector<> peak_input_rotation;
+};
+
+
+#endif
@@ -0,0 +1,121 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2010-2011 Alessandro Tasora
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_MODEL_H
+#define TERREMOTO_MODEL_H
+
+///////////////////////////////////////////////////
+//
+//   Construction of the temple models (floor,
+//   shaking table, columns made of stacked drums,
+//   capitals and beams) in a ChSystem.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "physics/ChSystem.h"
+#include "physics/ChBody.h"
+#include "physics/ChLinkLock.h"
+#include "physics/ChMaterialSurface.h"
+#include "assets/ChTexture.h"
+
+#include "terremoto_materials.h"
+
+
+/// The items of one temple model, as created by create_temple().
+/// Each ChSystem has its own TempleModel, so that several models
+/// can be simulated side by side.
+
+class TempleModel
+{
+public:
+	TempleModel() : use_material_table(false) {}
+
+		/// The texture asset of an image in the data directory, shared
+		/// by all the bodies of the model that use that image.
+	chrono::ChSharedPtr<chrono::ChTexture> GetTexture(const std::string& filename);
+
+	// Surfaces by material ID; null for the default surface of Chrono
+	chrono::ChSharedPtr<chrono::ChMaterialSurface> surfaces[MATERIAL_NIDS];
+
+	// Contact parameters of the material pairs, if the model uses the table
+	MaterialTable materials;
+	bool use_material_table;
+
+	chrono::ChSharedPtr<chrono::ChBody> floor;
+	chrono::ChSharedPtr<chrono::ChBody> table;
+	chrono::ChSharedPtr<chrono::ChLinkLockLock> link_earthquake;	// table to floor, where the earthquake motion is imposed
+
+	// Pointers to some objects that will be plotted
+	chrono::ChSharedPtr<chrono::ChBody> plot_brick_1;
+	chrono::ChSharedPtr<chrono::ChBody> plot_brick_2;
+
+	// All the column chunks (drums) created by create_column() and create_brickcolumn(),
+	// in creation order, so that their tilt can be monitored.
+	std::vector< chrono::ChSharedPtr<chrono::ChBody> > drums;
+
+	// Shared visualization assets: textures by image file, and hull meshes of
+	// the column chunks by shape (edges, radii, height). Only the first chunk
+	// of a shape has a mesh asset; the others map to it, so that the 3D view
+	// reuses its converted mesh (see attach_shared_mesh() in terremoto.cpp).
+	std::map< std::string, chrono::ChSharedPtr<chrono::ChTexture> > textures;
+	std::map< std::string, chrono::ChBody* > hull_sources;
+	std::map< chrono::ChBody*, chrono::ChBody* > hull_instances;
+};
+
+
+	// Utility function. Create a tapered column as a faceted convex hull.
+chrono::ChSharedPtr<chrono::ChBody> create_column(
+		chrono::ChSystem& mphysicalSystem,
+		TempleModel& model,
+		chrono::ChCoordsys<> base_pos,
+		int    col_nedges= 10,
+		double col_radius_hi= 0.45,
+		double col_radius_lo= 0.5,
+		double col_height=6,
+		double col_density= 3000);
+
+	// Utility function. As create_column(), but with the brick texture.
+chrono::ChSharedPtr<chrono::ChBody> create_brickcolumn(
+		chrono::ChSystem& mphysicalSystem,
+		TempleModel& model,
+		chrono::ChCoordsys<> base_pos,
+		int    col_nedges = 10,
+		double col_radius_hi = 0.45,
+		double col_radius_lo = 0.5,
+		double col_height = 6,
+		double col_density = 3000);
+
+	// Utility function. Load a motion from a two-column time/value text file
+	// in the data directory, shifted by t_offset and scaled by factor.
+chrono::ChFunction* create_motion(std::string filename_pos, double t_offset = 0, double factor =1.0);
+
+	// Create floor, shaking table with its earthquake link, and the simple
+	// (if simple_temple is true) or the complex temple on the table.
+	// All the drums share the given material; if a material table is given,
+	// instead, each body gets the surface of its material, and each contact
+	// the parameters of its pair of materials from the table.
+void create_temple(chrono::ChSystem& mphysicalSystem,
+				   TempleModel& model,
+				   bool simple_temple = true,
+				   const MaterialParams& material = MaterialParams(),
+				   const MaterialTable* materials = 0);
+
+	// Solver settings used for all the temple simulations. If deterministic,
+	// the system runs single-threaded, so that repeated runs give identical results.
+void set_solver_settings(chrono::ChSystem& mphysicalSystem, bool deterministic = false);
+
+
+#endif
@@ -0,0 +1,547 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "core/ChMath.h"
+
+#include "terremoto_motion.h"
+
+using namespace chrono;
+
+
+// Second derivatives at the knots of a natural spline through n values
+// sampled at step h, read (and written) every 'stride' elements.
+
+static void spline_second_derivatives(const double* y, double* ydd, size_t n, size_t stride, double h)
+{
+	for (size_t i = 0; i < n; ++i)
+		ydd[i*stride] = 0.0;
+	if (n < 3)
+		return;
+
+	// Natural spline: tridiagonal system for the inner second derivatives,
+	//   ydd[i-1] + 4 ydd[i] + ydd[i+1] = 6 (y[i+1] - 2 y[i] + y[i-1]) / h^2
+	// solved with the Thomas algorithm.
+	std::vector<double> c(n, 0.0);
+	std::vector<double> d(n, 0.0);
+	for (size_t i = 1; i + 1 < n; ++i)
+	{
+		double rhs = 6.0 * (y[(i+1)*stride] - 2.0*y[i*stride] + y[(i-1)*stride]) / (h*h);
+		double m = 4.0 - c[i-1];
+		c[i] = 1.0 / m;
+		d[i] = (rhs - d[i-1]) / m;
+	}
+	for (size_t i = n - 2; i >= 1; --i)
+		ydd[i*stride] = d[i] - c[i] * ydd[(i+1)*stride];
+}
+
+void MotionSpline::Setup(double mt0, double mh, const std::vector<double>& values)
+{
+	t0 = mt0;
+	h  = mh;
+	y  = values;
+	ydd.assign(y.size(), 0.0);
+	if (!y.empty())
+		spline_second_derivatives(&y[0], &ydd[0], y.size(), 1, h);
+}
+
+bool MotionSpline::Locate(double x, size_t& i, double& s) const
+{
+	if (y.size() < 2)
+		return false;
+	double u = (x - t0) / h;
+	if (u < 0 || u >= (double)(y.size() - 1))
+		return false;
+	i = (size_t)u;
+	s = u - (double)i;
+	return true;
+}
+
+double MotionSpline::EndSlope(bool last) const
+{
+	size_t n = y.size();
+	if (last)
+		return (y[n-1] - y[n-2])/h + (h/6.0) * (ydd[n-2] + 2.0*ydd[n-1]);
+	return (y[1] - y[0])/h - (h/6.0) * (2.0*ydd[0] + ydd[1]);
+}
+
+// Outside the knots the natural spline (zero second derivative at the ends)
+// continues as a straight line: value, speed and acceleration stay continuous.
+
+double MotionSpline::Get_y(double x)
+{
+	size_t i;
+	double s;
+	if (!Locate(x, i, s))
+	{
+		if (y.empty())
+			return 0;
+		if (y.size() < 2)
+			return y.front();
+		double t1 = t0 + h * (double)(y.size() - 1);
+		return (x < t0) ? y.front() + EndSlope(false) * (x - t0) : y.back() + EndSlope(true) * (x - t1);
+	}
+	double r = 1.0 - s;
+	return r*y[i] + s*y[i+1] + (h*h/6.0) * ((r*r*r - r)*ydd[i] + (s*s*s - s)*ydd[i+1]);
+}
+
+double MotionSpline::Get_y_dx(double x)
+{
+	size_t i;
+	double s;
+	if (!Locate(x, i, s))
+		return (y.size() < 2) ? 0 : EndSlope(x >= t0);
+	double r = 1.0 - s;
+	return (y[i+1] - y[i])/h + (h/6.0) * (-(3*r*r - 1)*ydd[i] + (3*s*s - 1)*ydd[i+1]);
+}
+
+double MotionSpline::Get_y_dxdx(double x)
+{
+	size_t i;
+	double s;
+	if (!Locate(x, i, s))
+		return 0;
+	return (1.0 - s)*ydd[i] + s*ydd[i+1];
+}
+
+
+
+MotionPreprocessing::MotionPreprocessing()
+{
+	enabled = true;
+	baseline_order = 1;
+	f_low = 0.1;
+	f_high = 25;
+	filter_order = 4;
+	step_multiple = 1;
+}
+
+
+// Remove the least-squares polynomial of given order from a signal
+// sampled at constant step (abscissa scaled to [-1,1] for conditioning).
+
+static void remove_polynomial(std::vector<double>& v, int order)
+{
+	size_t n = v.size();
+	if (order < 0 || n < 2)
+		return;
+	int m = order + 1;
+
+	std::vector<double> N(m*m, 0.0);
+	std::vector<double> b(m, 0.0);
+	std::vector<double> p(m);
+	for (size_t i = 0; i < n; ++i)
+	{
+		double x = 2.0 * (double)i / (double)(n - 1) - 1.0;
+		p[0] = 1.0;
+		for (int k = 1; k < m; ++k)
+			p[k] = p[k-1] * x;
+		for (int r = 0; r < m; ++r)
+		{
+			b[r] += p[r] * v[i];
+			for (int c = 0; c < m; ++c)
+				N[r*m + c] += p[r] * p[c];
+		}
+	}
+	// Gauss elimination with partial pivoting on the small normal system
+	for (int k = 0; k < m; ++k)
+	{
+		int piv = k;
+		for (int r = k + 1; r < m; ++r)
+			if (fabs(N[r*m + k]) > fabs(N[piv*m + k]))
+				piv = r;
+		for (int c = 0; c < m; ++c)
+			std::swap(N[k*m + c], N[piv*m + c]);
+		std::swap(b[k], b[piv]);
+		if (N[k*m + k] == 0)
+			return;
+		for (int r = k + 1; r < m; ++r)
+		{
+			double f = N[r*m + k] / N[k*m + k];
+			for (int c = k; c < m; ++c)
+				N[r*m + c] -= f * N[k*m + c];
+			b[r] -= f * b[k];
+		}
+	}
+	std::vector<double> coef(m);
+	for (int k = m - 1; k >= 0; --k)
+	{
+		double s = b[k];
+		for (int c = k + 1; c < m; ++c)
+			s -= N[k*m + c] * coef[c];
+		coef[k] = s / N[k*m + k];
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		double x = 2.0 * (double)i / (double)(n - 1) - 1.0;
+		double fit = 0;
+		for (int k = m - 1; k >= 0; --k)
+			fit = fit * x + coef[k];
+		v[i] -= fit;
+	}
+}
+
+
+// One second-order section (biquad), transposed direct form II.
+
+class Biquad
+{
+public:
+	Biquad(double mb0, double mb1, double mb2, double ma1, double ma2) : b0(mb0), b1(mb1), b2(mb2), a1(ma1), a2(ma2) {}
+
+	void Filter(std::vector<double>& v) const
+	{
+		double z1 = 0, z2 = 0;
+		for (size_t i = 0; i < v.size(); ++i)
+		{
+			double in  = v[i];
+			double out = b0*in + z1;
+			z1 = b1*in - a1*out + z2;
+			z2 = b2*in - a2*out;
+			v[i] = out;
+		}
+	}
+
+	double b0, b1, b2, a1, a2;
+};
+
+// Butterworth sections of given (even) order, low-pass or high-pass,
+// with the bilinear transform (prewarped at the corner frequency).
+
+static void butterworth_sections(double fc, double dt, int order, bool highpass, std::vector<Biquad>& sections)
+{
+	double w0 = CH_C_2PI * fc * dt;
+	double cw = cos(w0);
+	double sw = sin(w0);
+	int nsec = std::max(1, order / 2);
+	for (int k = 1; k <= nsec; ++k)
+	{
+		double Q = 1.0 / (2.0 * cos((2.0*k - 1.0) * CH_C_PI / (4.0 * nsec)));
+		double alpha = sw / (2.0 * Q);
+		double a0 = 1.0 + alpha;
+		double b0 = highpass ? (1.0 + cw) / 2.0 : (1.0 - cw) / 2.0;
+		double b1 = highpass ? -(1.0 + cw) : (1.0 - cw);
+		sections.push_back(Biquad(b0/a0, b1/a0, b0/a0, (-2.0*cw)/a0, (1.0 - alpha)/a0));
+	}
+}
+
+// Zero-phase band-pass: the cascade is applied forward and backward, on the
+// signal padded with zeros at both ends to absorb the filter transients.
+
+static void bandpass_zero_phase(std::vector<double>& v, double dt, const MotionPreprocessing& settings)
+{
+	std::vector<Biquad> sections;
+	double nyquist = 0.5 / dt;
+	if (settings.f_low > 0 && settings.f_low < nyquist)
+		butterworth_sections(settings.f_low, dt, settings.filter_order, true, sections);
+	if (settings.f_high > 0 && settings.f_high < nyquist)
+		butterworth_sections(settings.f_high, dt, settings.filter_order, false, sections);
+	if (sections.empty())
+		return;
+
+	// padding length as suggested by Converse & Brady, 1.5 * order / f_corner
+	double f_corner = (settings.f_low > 0) ? settings.f_low : settings.f_high;
+	size_t npad = (size_t)(1.5 * settings.filter_order / f_corner / dt);
+	npad = std::min(npad, 4 * v.size());
+
+	std::vector<double> padded(v.size() + 2*npad, 0.0);
+	std::copy(v.begin(), v.end(), padded.begin() + npad);
+
+	for (size_t k = 0; k < sections.size(); ++k)
+		sections[k].Filter(padded);
+	std::reverse(padded.begin(), padded.end());
+	for (size_t k = 0; k < sections.size(); ++k)
+		sections[k].Filter(padded);
+	std::reverse(padded.begin(), padded.end());
+
+	std::copy(padded.begin() + npad, padded.begin() + npad + v.size(), v.begin());
+}
+
+// Cosine taper of the first and last 'fraction' of the samples, to zero
+// at the ends.
+
+static void taper_ends(std::vector<double>& v, double fraction)
+{
+	size_t n = v.size();
+	size_t ntaper = (size_t)(fraction * (double)n);
+	if (ntaper < 1 || 2 * ntaper > n)
+		return;
+	for (size_t i = 0; i < ntaper; ++i)
+	{
+		double w = 0.5 * (1.0 - cos(CH_C_PI * (double)i / (double)ntaper));
+		v[i] *= w;
+		v[n - 1 - i] *= w;
+	}
+}
+
+static void integrate_trapezoidal(std::vector<double>& v, double dt, double initial)
+{
+	double prev = v.empty() ? 0 : v[0];
+	if (!v.empty())
+		v[0] = initial;
+	for (size_t i = 1; i < v.size(); ++i)
+	{
+		double cur = v[i];
+		v[i] = v[i-1] + 0.5 * (prev + cur) * dt;
+		prev = cur;
+	}
+}
+
+
+void preprocess_record(const MotionRecord& record,
+					   char quantity,
+					   const MotionPreprocessing& settings,
+					   double dt,
+					   std::vector<double>& displacement,
+					   double& t_start)
+{
+	displacement.clear();
+	t_start = 0;
+	size_t nrec = record.GetNsamples();
+	if (nrec < 2)
+		return;
+
+	// 1) resample at the (first) record step, if the record is not uniform
+	double h = record.uniform ? record.dt : record.GetTime(1) - record.GetTime(0);
+	double t_first = record.GetTime(0);
+	double t_last  = record.GetTime(nrec - 1);
+	size_t n = (size_t)floor((t_last - t_first) / h + 0.5) + 1;
+	std::vector<double> v(n);
+	size_t j = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		double t = t_first + h * (double)i;
+		while (j + 2 < nrec && record.GetTime(j + 1) <= t)
+			++j;
+		double ta = record.GetTime(j);
+		double tb = record.GetTime(j + 1);
+		double s = (tb > ta) ? std::min(1.0, std::max(0.0, (t - ta) / (tb - ta))) : 0.0;
+		v[i] = (1.0 - s) * record.value[j] + s * record.value[j + 1];
+	}
+
+	// 2) to acceleration
+	double u0 = (quantity == 'U') ? v[0] : 0.0;
+	double v0 = 0;
+	if (quantity == 'U')
+	{
+		v0 = (v[1] - v[0]) / h;
+		std::vector<double> a(n, 0.0);
+		for (size_t i = 1; i + 1 < n; ++i)
+			a[i] = (v[i+1] - 2.0*v[i] + v[i-1]) / (h*h);
+		v.swap(a);
+	}
+	else if (quantity == 'V')
+	{
+		v0 = v[0];
+		std::vector<double> a(n, 0.0);
+		for (size_t i = 1; i + 1 < n; ++i)
+			a[i] = (v[i+1] - v[i-1]) / (2.0*h);
+		v.swap(a);
+	}
+
+	// 3) baseline correction and band-pass filtering of the acceleration
+	remove_polynomial(v, settings.baseline_order);
+	bandpass_zero_phase(v, h, settings);
+
+	// 4) back to displacement. The speed is tapered to zero over 5% of the
+	//    record at each end, so that the table starts and stops at rest:
+	//    the straight extension of the spline past its ends barely moves.
+	integrate_trapezoidal(v, h, v0);
+	taper_ends(v, 0.05);
+	integrate_trapezoidal(v, h, u0);
+
+	// 5) resample at the step of the motion function; the signal is already
+	//    low-passed, so linear interpolation of the fine samples suffices.
+	size_t nout = (size_t)floor((t_last - t_first) / dt) + 1;
+	displacement.resize(nout);
+	for (size_t i = 0; i < nout; ++i)
+	{
+		double u = (dt * (double)i) / h;
+		size_t k = std::min((size_t)u, n - 2);
+		double s = std::min(1.0, u - (double)k);
+		displacement[i] = (1.0 - s) * v[k] + s * v[k + 1];
+	}
+	t_start = t_first;
+}
+
+
+MotionSpline* create_preprocessed_motion(const MotionRecord& record,
+										 char quantity,
+										 const MotionPreprocessing& settings,
+										 double dt,
+										 double t_offset,
+										 double factor)
+{
+	std::vector<double> displacement;
+	double t_start;
+	preprocess_record(record, quantity, settings, dt, displacement, t_start);
+	for (size_t i = 0; i < displacement.size(); ++i)
+		displacement[i] *= factor;
+	return new MotionSpline(t_start + t_offset, dt, displacement);
+}
+
+
+
+bool MultiComponentMotion::Load(const std::string& filename, double t_offset, double factor)
+{
+	FILE* f = fopen(filename.c_str(), "r");
+	if (!f)
+		return false;
+
+	int ncolumns = 0;
+	std::vector<double> times;
+	std::vector<double> rows;
+	char line[512];
+	while (fgets(line, sizeof(line), f))
+	{
+		char* p = line;
+		while (*p == ' ' || *p == '\t')
+			++p;
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0)
+			continue;
+		double columns[MOTION_NCOMPONENTS + 1];
+		int n = 0;
+		while (n < MOTION_NCOMPONENTS + 1)
+		{
+			char* end;
+			double v = strtod(p, &end);
+			if (end == p)
+				break;
+			columns[n++] = v;
+			p = end;
+		}
+		// the first line with a time and some component fixes the columns
+		// (a one-column line, ex. a sample count, is skipped)
+		if (n < 2)
+			continue;
+		if (ncolumns == 0)
+			ncolumns = n;
+		if (n != ncolumns)
+			continue;
+		times.push_back(columns[0] + t_offset);
+		for (int c = 1; c < n; ++c)
+			rows.push_back(columns[c] * factor);
+	}
+	fclose(f);
+
+	// no samples, or too few to interpolate
+	size_t nsamples = times.size();
+	if (nsamples < 2)
+		return false;
+	int mncomponents = ncolumns - 1;
+
+	// Constant step, or resampling at the mean step
+	double mh = (times.back() - times.front()) / (double)(nsamples - 1);
+	bool uniform = true;
+	for (size_t i = 1; i < nsamples && uniform; ++i)
+		if (fabs(times[i] - times[i-1] - mh) > 1e-6 * mh)
+			uniform = false;
+	if (!uniform)
+	{
+		std::vector<double> resampled(nsamples * mncomponents);
+		size_t k = 0;
+		for (size_t i = 0; i < nsamples; ++i)
+		{
+			double t = times.front() + mh * (double)i;
+			while (k + 2 < nsamples && times[k+1] <= t)
+				++k;
+			double s = (times[k+1] > times[k]) ? std::min(1.0, std::max(0.0, (t - times[k]) / (times[k+1] - times[k]))) : 0.0;
+			for (int c = 0; c < mncomponents; ++c)
+				resampled[i*mncomponents + c] = (1.0 - s) * rows[k*mncomponents + c] + s * rows[(k+1)*mncomponents + c];
+		}
+		rows.swap(resampled);
+	}
+
+	Setup(times.front(), mh, mncomponents, rows);
+	return true;
+}
+
+void MultiComponentMotion::Setup(double mt0, double mh, int mncomponents, const std::vector<double>& rows)
+{
+	t0 = mt0;
+	h  = mh;
+	ncomponents = std::min(std::max(mncomponents, 0), (int)MOTION_NCOMPONENTS);
+	y  = rows;
+	ydd.assign(y.size(), 0.0);
+	size_t n = GetNsamples();
+	for (int c = 0; c < ncomponents && n > 0; ++c)
+		spline_second_derivatives(&y[c], &ydd[c], n, ncomponents, h);
+	cached = false;
+	for (int c = 0; c < MOTION_NCOMPONENTS; ++c)
+		value[c] = speed[c] = acceleration[c] = 0;
+}
+
+void MultiComponentMotion::Evaluate(double x)
+{
+	if (cached && x == cached_x)
+		return;
+	cached = true;
+	cached_x = x;
+
+	size_t n = GetNsamples();
+	if (n < 2)
+		return;
+
+	double u = (x - t0) / h;
+	if (u < 0 || u >= (double)(n - 1))
+	{
+		// constant before and after the record
+		const double* yrow = &y[(u < 0) ? 0 : (n - 1) * ncomponents];
+		for (int c = 0; c < ncomponents; ++c)
+		{
+			value[c] = yrow[c];
+			speed[c] = acceleration[c] = 0;
+		}
+		return;
+	}
+
+	// One interval search for all the components, then the spline
+	// weights, shared too
+	size_t i = (size_t)u;
+	double s = u - (double)i;
+	double r = 1.0 - s;
+	double w_val = h*h/6.0;
+	double a_val = r*r*r - r;
+	double b_val = s*s*s - s;
+	double a_dx = -(3*r*r - 1) * h/6.0;
+	double b_dx =  (3*s*s - 1) * h/6.0;
+	const double* y0 = &y[i * ncomponents];
+	const double* y1 = y0 + ncomponents;
+	const double* d0 = &ydd[i * ncomponents];
+	const double* d1 = d0 + ncomponents;
+	for (int c = 0; c < ncomponents; ++c)
+	{
+		value[c]        = r*y0[c] + s*y1[c] + w_val * (a_val*d0[c] + b_val*d1[c]);
+		speed[c]        = (y1[c] - y0[c])/h + a_dx*d0[c] + b_dx*d1[c];
+		acceleration[c] = r*d0[c] + s*d1[c];
+	}
+}
+
+
+void set_link_motion(ChLinkLock& link, const std::shared_ptr<MultiComponentMotion>& motion)
+{
+	int n = motion->GetNcomponents();
+	if (n > MOTION_X) link.SetMotion_X(new MotionComponent(motion, MOTION_X));
+	if (n > MOTION_Y) link.SetMotion_Y(new MotionComponent(motion, MOTION_Y));
+	if (n > MOTION_Z) link.SetMotion_Z(new MotionComponent(motion, MOTION_Z));
+	if (n > MOTION_RX)
+	{
+		link.Set_angleset(ANGLESET_RXYZ);
+		link.SetMotion_ang(new MotionComponent(motion, MOTION_RX));
+		if (n > MOTION_RY) link.SetMotion_ang2(new MotionComponent(motion, MOTION_RY));
+		if (n > MOTION_RZ) link.SetMotion_ang3(new MotionComponent(motion, MOTION_RZ));
+	}
+}
@@ -0,0 +1,220 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_MOTION_H
+#define TERREMOTO_MOTION_H
+
+///////////////////////////////////////////////////
+//
+//   Motion functions imposed to the shaking table,
+//   and the preprocessing that turns a raw record
+//   into a smooth displacement function:
+//
+//     record -> acceleration -> baseline correction
+//     -> band-pass filter -> integration to displacement
+//     (the speed tapered to zero at the ends)
+//     -> resampling to the solver step -> C2 spline
+//
+///////////////////////////////////////////////////
+
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "motion_functions/ChFunction_Base.h"
+#include "physics/ChLinkLock.h"
+
+#include "terremoto_records.h"
+
+
+/// Natural cubic spline through values sampled at a constant step h,
+/// starting at t0. Value, first and second derivative are continuous,
+/// and evaluation is O(1): no search, just an index computation.
+/// Before t0 and after the last sample it continues as a straight line
+/// (the second derivative of a natural spline is zero at its ends), so
+/// the derivatives stay continuous there too.
+
+class MotionSpline : public chrono::ChFunction
+{
+	CH_RTTI(MotionSpline, chrono::ChFunction);
+
+public:
+	MotionSpline() : t0(0), h(1) {}
+	MotionSpline(double mt0, double mh, const std::vector<double>& values) { Setup(mt0, mh, values); }
+
+		/// Build the spline (computes the second derivatives at the knots).
+	void Setup(double mt0, double mh, const std::vector<double>& values);
+
+	double GetStart() const { return t0; }
+	double GetStep() const { return h; }
+	size_t GetNsamples() const { return y.size(); }
+
+	chrono::ChFunction* new_Duplicate() { return new MotionSpline(*this); }
+
+	double Get_y      (double x);
+	double Get_y_dx   (double x);
+	double Get_y_dxdx (double x);
+
+	void Estimate_x_range(double& xmin, double& xmax) { xmin = t0; xmax = t0 + h * (double)(y.size() - 1); }
+
+private:
+		// Locate the interval of x: returns false if x is outside the
+		// knots, otherwise sets the interval i and the local abscissa s in [0,1].
+	bool Locate(double x, size_t& i, double& s) const;
+
+		// Speed at the first or the last knot
+	double EndSlope(bool last) const;
+
+	double t0;
+	double h;
+	std::vector<double> y;		// values at knots
+	std::vector<double> ydd;	// second derivatives at knots
+};
+
+
+/// Settings of the preprocessing of a ground-motion record.
+
+class MotionPreprocessing
+{
+public:
+	MotionPreprocessing();
+
+	bool   enabled;			// if false, records are used raw, as sampled
+	int    baseline_order;	// order of the least-squares polynomial removed from the acceleration, -1 for none
+	double f_low;			// corner of the high-pass Butterworth filter, Hz (0 for none)
+	double f_high;			// corner of the low-pass Butterworth filter, Hz (0 for none)
+	int    filter_order;	// order of each Butterworth filter (even); it is applied forward and backward, for zero phase
+	int    step_multiple;	// the motion is resampled at this multiple of the solver step
+};
+
+
+/// Run the preprocessing pipeline on a record whose samples are of the
+/// given quantity ('U' displacement, 'V' speed, 'A' acceleration), and
+/// return the displacement sampled at step dt from the record start.
+
+void preprocess_record(const MotionRecord& record,
+					   char quantity,
+					   const MotionPreprocessing& settings,
+					   double dt,
+					   std::vector<double>& displacement,
+					   double& t_start);
+
+
+/// Create the smooth displacement function of a preprocessed record, shifted
+/// by t_offset and scaled by factor. The function is owned by the caller.
+
+MotionSpline* create_preprocessed_motion(const MotionRecord& record,
+										 char quantity,
+										 const MotionPreprocessing& settings,
+										 double dt,
+										 double t_offset = 0,
+										 double factor = 1.0);
+
+
+
+/// Components of a multi-component motion, in the frame of the earthquake
+/// link: translations along X, Y (vertical) and Z, and rotations about them.
+
+enum MotionComponentId
+{
+	MOTION_X = 0,
+	MOTION_Y,
+	MOTION_Z,
+	MOTION_RX,
+	MOTION_RY,
+	MOTION_RZ,
+	MOTION_NCOMPONENTS
+};
+
+
+/// Several motion components from one combined record, each a natural
+/// cubic spline on the same knots. All the components are evaluated in
+/// one pass (one interval search, then a loop on the components) and
+/// cached, so that the per-axis functions of the link, which evaluate
+/// the same time, cost a comparison each.
+
+class MultiComponentMotion
+{
+public:
+	MultiComponentMotion() : t0(0), h(1), ncomponents(0), cached_x(0), cached(false) {}
+
+		/// Load a combined record: text lines  t x [y [z [rx [ry [rz]]]]]  with
+		/// displacements in m and rotations in rad ('#' lines are skipped); the
+		/// number of columns of the first line gives the components. Times are
+		/// shifted by t_offset, values scaled by factor. Records not sampled at
+		/// constant step are resampled, linearly, at their mean step.
+		/// Returns false if the file cannot be read or has less than two rows.
+	bool Load(const std::string& filename, double t_offset = 0, double factor = 1.0);
+
+		/// Build from values sampled at step h from t0, one row of
+		/// ncomponents values per sample.
+	void Setup(double mt0, double mh, int mncomponents, const std::vector<double>& rows);
+
+	int GetNcomponents() const { return ncomponents; }
+	size_t GetNsamples() const { return ncomponents ? y.size() / ncomponents : 0; }
+
+		/// Evaluate all components at x (cached: only the first call at a
+		/// new x computes).
+	void Evaluate(double x);
+
+	double GetValue(int component) const { return value[component]; }
+	double GetSpeed(int component) const { return speed[component]; }
+	double GetAcceleration(int component) const { return acceleration[component]; }
+
+	void Estimate_x_range(double& xmin, double& xmax) const { xmin = t0; xmax = t0 + h * (double)(GetNsamples() - 1); }
+
+private:
+	double t0;
+	double h;
+	int ncomponents;
+	std::vector<double> y;		// values at knots, row by row
+	std::vector<double> ydd;	// second derivatives at knots, row by row
+
+	double cached_x;
+	bool cached;
+	double value[MOTION_NCOMPONENTS];
+	double speed[MOTION_NCOMPONENTS];
+	double acceleration[MOTION_NCOMPONENTS];
+};
+
+
+/// One component of a multi-component motion, as a ChFunction for one
+/// axis of the link. The components of a motion share it.
+
+class MotionComponent : public chrono::ChFunction
+{
+	CH_RTTI(MotionComponent, chrono::ChFunction);
+
+public:
+	MotionComponent(const std::shared_ptr<MultiComponentMotion>& mmotion, int mcomponent) : motion(mmotion), component(mcomponent) {}
+
+	chrono::ChFunction* new_Duplicate() { return new MotionComponent(*this); }
+
+	double Get_y      (double x) { motion->Evaluate(x); return motion->GetValue(component); }
+	double Get_y_dx   (double x) { motion->Evaluate(x); return motion->GetSpeed(component); }
+	double Get_y_dxdx (double x) { motion->Evaluate(x); return motion->GetAcceleration(component); }
+
+	void Estimate_x_range(double& xmin, double& xmax) { motion->Estimate_x_range(xmin, xmax); }
+
+private:
+	std::shared_ptr<MultiComponentMotion> motion;
+	int component;
+};
+
+
+/// Impose the components of a multi-component motion to a link: X, Y, Z
+/// as its translations, and the rotations, if any, as its angles in
+/// the RXYZ set, about the axes of the link frame.
+
+void set_link_motion(chrono::ChLinkLock& link, const std::shared_ptr<MultiComponentMotion>& motion);
+
+
+#endif
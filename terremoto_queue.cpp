@@ -0,0 +1,416 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "core/ChLog.h"
+#include "core/ChTimer.h"
+
+#include "terremoto_queue.h"
+#include "terremoto_files.h"
+
+using namespace chrono;
+
+
+static const char* case_suffix = ".case";
+
+
+void write_case(std::ostream& out, const RunCase& mcase)
+{
+	out.precision(17);
+	out << "label "           << mcase.label << "\n";
+	out << "record_set "      << mcase.record_set << "\n";
+	out << "record_h "        << mcase.record_h << "\n";
+	out << "record_v "        << mcase.record_v << "\n";
+	out << "record_multi "    << mcase.record_multi << "\n";
+	out << "stream_h "        << mcase.stream_h << "\n";
+	out << "stream_v "        << mcase.stream_v << "\n";
+	out << "stream_window "   << mcase.stream_window << "\n";
+	out << "ampl_factor "     << mcase.ampl_factor << "\n";
+	out << "time_offset "     << mcase.time_offset << "\n";
+	out << "t_save "          << mcase.t_save << "\n";
+	out << "t_end "           << mcase.t_end << "\n";
+	out << "timestep "        << mcase.timestep << "\n";
+	out << "simple_temple "   << (mcase.simple_temple ? 1 : 0) << "\n";
+	out << "friction "        << mcase.material.friction << "\n";
+	out << "compliance "      << mcase.material.compliance << "\n";
+	out << "dampingf "        << mcase.material.dampingf << "\n";
+	for (size_t i = 0; i < mcase.material_pairs.size(); ++i)
+		out << "material_pair "   << format_material_pair(mcase.material_pairs[i]) << "\n";
+	out << "preprocessing "   << (mcase.preprocessing.enabled ? 1 : 0) << "\n";
+	out << "baseline_order "  << mcase.preprocessing.baseline_order << "\n";
+	out << "f_low "           << mcase.preprocessing.f_low << "\n";
+	out << "f_high "          << mcase.preprocessing.f_high << "\n";
+	out << "filter_order "    << mcase.preprocessing.filter_order << "\n";
+	out << "step_multiple "   << mcase.preprocessing.step_multiple << "\n";
+	out << "save_full_dumps " << (mcase.save_full_dumps ? 1 : 0) << "\n";
+	out << "deterministic "   << (mcase.deterministic ? 1 : 0) << "\n";
+	out << "log_decimation "  << mcase.capture.decimation << "\n";
+	out << "trigger_impulse " << mcase.capture.contact_impulse << "\n";
+	out << "trigger_rel_acc " << mcase.capture.rel_acc << "\n";
+	out << "trigger_tilt_rate " << mcase.capture.tilt_rate << "\n";
+	out << "capture_before "  << mcase.capture.t_before << "\n";
+	out << "capture_after "   << mcase.capture.t_after << "\n";
+}
+
+bool read_case(std::istream& in, RunCase& mcase, const RecordLibrary& library)
+{
+	int use_barrier = -1;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (line.empty() || line[0] == '#')
+			continue;
+		size_t sep = line.find(' ');
+		std::string key   = line.substr(0, sep);
+		std::string value = (sep == std::string::npos) ? "" : line.substr(sep + 1);
+		double number = atof(value.c_str());
+
+		if      (key == "label")           mcase.label = value;
+		else if (key == "record_set")      mcase.record_set = value;
+		else if (key == "record_h")        mcase.record_h = value;
+		else if (key == "record_v")        mcase.record_v = value;
+		else if (key == "record_multi")    mcase.record_multi = value;
+		else if (key == "stream_h")        mcase.stream_h = value;
+		else if (key == "stream_v")        mcase.stream_v = value;
+		else if (key == "stream_window")   mcase.stream_window = (int)number;
+		else if (key == "use_barrier")     use_barrier = (int)number;
+		else if (key == "ampl_factor")     mcase.ampl_factor = number;
+		else if (key == "time_offset")     mcase.time_offset = number;
+		else if (key == "t_save")          mcase.t_save = number;
+		else if (key == "t_end")           mcase.t_end = number;
+		else if (key == "timestep")        mcase.timestep = number;
+		else if (key == "simple_temple")   mcase.simple_temple = number != 0;
+		else if (key == "friction")        mcase.material.friction = number;
+		else if (key == "compliance")      mcase.material.compliance = number;
+		else if (key == "dampingf")        mcase.material.dampingf = number;
+		else if (key == "material_pair")
+		{
+			MaterialPair pair;
+			if (!parse_material_pair(value, pair))
+			{
+				GetLog() << "Bad material pair in case: " << value.c_str() << "\n";
+				return false;
+			}
+			mcase.material_pairs.push_back(pair);
+		}
+		else if (key == "preprocessing")   mcase.preprocessing.enabled = number != 0;
+		else if (key == "baseline_order")  mcase.preprocessing.baseline_order = (int)number;
+		else if (key == "f_low")           mcase.preprocessing.f_low = number;
+		else if (key == "f_high")          mcase.preprocessing.f_high = number;
+		else if (key == "filter_order")    mcase.preprocessing.filter_order = (int)number;
+		else if (key == "step_multiple")   mcase.preprocessing.step_multiple = (int)number;
+		else if (key == "save_full_dumps") mcase.save_full_dumps = number != 0;
+		else if (key == "deterministic")   mcase.deterministic = number != 0;
+		else if (key == "log_decimation")  mcase.capture.decimation = (int)number;
+		else if (key == "trigger_impulse") mcase.capture.contact_impulse = number;
+		else if (key == "trigger_rel_acc") mcase.capture.rel_acc = number;
+		else if (key == "trigger_tilt_rate") mcase.capture.tilt_rate = number;
+		else if (key == "capture_before")  mcase.capture.t_before = number;
+		else if (key == "capture_after")   mcase.capture.t_after = number;
+		else
+		{
+			GetLog() << "Unknown key in case: " << key.c_str() << "\n";
+			return false;
+		}
+	}
+
+	// The records of the barrier variant, as in the interactive run
+	if (use_barrier >= 0)
+	{
+		std::vector<const RecordInfo*> records_h = library.Select(use_barrier ? "barrier=1 quantity=U direction=h" : "barrier=0 quantity=U direction=h");
+		if (records_h.empty())
+		{
+			GetLog() << "No records for use_barrier " << use_barrier << "\n";
+			return false;
+		}
+		const RecordInfo* record_v = library.FindCompanion(*records_h[0]);
+		mcase.record_set = records_h[0]->set;
+		mcase.record_h   = records_h[0]->name;
+		mcase.record_v   = record_v ? record_v->name : "";
+	}
+	return true;
+}
+
+
+
+WorkQueue::WorkQueue(const std::string& mdirectory, double mlease, int mmax_attempts)
+	: directory(mdirectory),
+	  lease(mlease),
+	  max_attempts(mmax_attempts),
+	  worker_id(host_process_id()),
+	  nfailed(0)
+{
+	make_directory(directory);
+}
+
+std::string WorkQueue::Path(const std::string& name, const char* suffix) const
+{
+	return join_path(directory, name + suffix);
+}
+
+long WorkQueue::FileSystemNow() const
+{
+	std::string probe = join_path(directory, "." + worker_id + ".clock");
+	FILE* f = fopen(probe.c_str(), "w");
+	if (f)
+		fclose(f);
+	long now = file_mtime(probe);
+	remove(probe.c_str());
+	return now;
+}
+
+bool WorkQueue::Enqueue(const RunCase& mcase)
+{
+	std::ostringstream content;
+	write_case(content, mcase);
+	if (!write_replace(Path(mcase.label, case_suffix), content.str()))
+	{
+		GetLog() << "Cannot write case " << mcase.label.c_str() << " in " << directory.c_str() << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool WorkQueue::ReadClaim(const std::string& name, std::string& owner, int& attempt) const
+{
+	std::ifstream in(Path(name, ".claim").c_str());
+	owner.clear();
+	attempt = 1;
+	return (bool)(in >> owner >> attempt);
+}
+
+bool WorkQueue::OwnsClaim(const std::string& name) const
+{
+	std::string owner;
+	int attempt;
+	return ReadClaim(name, owner, attempt) && owner == worker_id;
+}
+
+bool WorkQueue::TakeOverExpired(const std::string& name, int& attempt)
+{
+	std::string claim = Path(name, ".claim");
+	long mtime = file_mtime(claim);
+	if (mtime < 0 || (double)(FileSystemNow() - mtime) <= lease)
+		return false;
+
+	// Of the workers that see the claim expired, only the one that creates
+	// the takeover lock goes on. A lock left by a worker that crashed while
+	// holding it expires as the claims do.
+	std::string lock = Path(name, ".takeover");
+	if (!create_exclusive(lock, worker_id + "\n"))
+	{
+		long lock_mtime = file_mtime(lock);
+		if (lock_mtime >= 0 && (double)(FileSystemNow() - lock_mtime) > lease)
+			remove(lock.c_str());
+		return false;
+	}
+
+	// The claim may have been renewed, taken over or released meanwhile.
+	// It is replaced in place, so that it exists throughout and no plain
+	// claim (with the attempts reset to 1) can slip in.
+	bool taken = false;
+	std::string owner;
+	int previous;
+	if (file_mtime(claim) == mtime && ReadClaim(name, owner, previous))
+	{
+		attempt = previous + 1;
+		GetLog() << "Claim of " << name.c_str() << " by " << owner.c_str() << " expired, attempt " << attempt << "\n";
+
+		char content[300];
+		sprintf(content, "%s %d\n", worker_id.c_str(), attempt);
+		taken = write_replace(claim, content);
+	}
+	remove(lock.c_str());
+	return taken;
+}
+
+bool WorkQueue::Claim(std::string& name, RunCase& mcase, const RecordLibrary& library)
+{
+	std::vector<std::string> files, subdirs;
+	list_directory(directory, files, subdirs);
+
+	size_t nsuffix = strlen(case_suffix);
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		const std::string& file = files[i];
+		if (file.size() <= nsuffix || file.compare(file.size() - nsuffix, nsuffix, case_suffix) != 0)
+			continue;
+		std::string mname = file.substr(0, file.size() - nsuffix);
+		if (file_mtime(Path(mname, ".done")) >= 0)
+			continue;
+
+		int attempt = 1;
+		std::string claim = Path(mname, ".claim");
+		if (!create_exclusive(claim, worker_id + " 1\n") && !TakeOverExpired(mname, attempt))
+			continue;
+
+		// done by another worker between the check and the claim
+		if (file_mtime(Path(mname, ".done")) >= 0)
+		{
+			remove(claim.c_str());
+			continue;
+		}
+
+		if (attempt > max_attempts)
+		{
+			GetLog() << "Case " << mname.c_str() << " abandoned after " << max_attempts << " attempts\n";
+			Complete(mname, false, 0);
+			++nfailed;
+			continue;
+		}
+
+		RunCase qcase;
+		std::ifstream in(Path(mname, case_suffix).c_str());
+		if (!read_case(in, qcase, library))
+		{
+			GetLog() << "Cannot read case " << mname.c_str() << "\n";
+			Complete(mname, false, 0);
+			++nfailed;
+			continue;
+		}
+		if (qcase.label.empty())
+			qcase.label = mname;
+		qcase.output_dir = Path(mname, ".results");
+		make_directory(qcase.output_dir);
+
+		name = mname;
+		mcase = qcase;
+		return true;
+	}
+	return false;
+}
+
+int WorkQueue::TakeFailed()
+{
+	int n = nfailed;
+	nfailed = 0;
+	return n;
+}
+
+void WorkQueue::Heartbeat(const std::string& name)
+{
+	// a claim that expired while this worker stalled is another's now
+	if (OwnsClaim(name))
+		touch_file(Path(name, ".claim"));
+}
+
+bool WorkQueue::Complete(const std::string& name, bool ok, double runtime)
+{
+	if (!OwnsClaim(name))
+	{
+		GetLog() << "Claim of " << name.c_str() << " lost to another worker: outcome not recorded\n";
+		return false;
+	}
+	std::ostringstream content;
+	content << "status "  << (ok ? "ok" : "failed") << "\n"
+			<< "worker "  << worker_id << "\n"
+			<< "runtime " << runtime << "\n";
+	write_replace(Path(name, ".done"), content.str());
+	remove(Path(name, ".claim").c_str());
+	return true;
+}
+
+int WorkQueue::CountPending() const
+{
+	std::vector<std::string> files, subdirs;
+	list_directory(directory, files, subdirs);
+
+	int npending = 0;
+	size_t nsuffix = strlen(case_suffix);
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		const std::string& file = files[i];
+		if (file.size() <= nsuffix || file.compare(file.size() - nsuffix, nsuffix, case_suffix) != 0)
+			continue;
+		if (file_mtime(Path(file.substr(0, file.size() - nsuffix), ".done")) < 0)
+			++npending;
+	}
+	return npending;
+}
+
+
+
+int run_queue(WorkQueue& queue, const RecordLibrary& library, Telemetry* telemetry)
+{
+	if (telemetry)
+		telemetry->SetCasesTotal(queue.CountPending());
+
+	int nfailed = 0;
+	std::string name;
+	RunCase mcase;
+	while (true)
+	{
+		bool claimed = queue.Claim(name, mcase, library);
+
+		// cases failed without running: abandoned, or unreadable
+		for (int i = queue.TakeFailed(); i > 0; --i)
+		{
+			if (telemetry)
+				telemetry->CaseDone(false);
+			++nfailed;
+		}
+
+		if (!claimed)
+		{
+			// The cases left are run by other workers: wait, in case
+			// one of them crashes and its claim expires.
+			if (queue.CountPending() == 0)
+				break;
+			std::this_thread::sleep_for(std::chrono::duration<double>(std::min(queue.GetLease() / 2, 30.0)));
+			continue;
+		}
+
+		// Renew the lease from a separate thread while the case runs
+		std::mutex heartbeat_mutex;
+		std::condition_variable heartbeat_cond;
+		bool running = true;
+		std::thread heartbeat([&]()
+		{
+			std::unique_lock<std::mutex> lock(heartbeat_mutex);
+			while (!heartbeat_cond.wait_for(lock, std::chrono::duration<double>(queue.GetLease() / 4), [&]{ return !running; }))
+				queue.Heartbeat(name);
+		});
+
+		ChTimer<double> timer;
+		timer.start();
+		bool ok = run_case(mcase, library, telemetry ? &telemetry->GetWorker(0) : 0);
+		timer.stop();
+
+		{
+			std::lock_guard<std::mutex> lock(heartbeat_mutex);
+			running = false;
+		}
+		heartbeat_cond.notify_all();
+		heartbeat.join();
+
+		// a run whose claim was lost is retried by another worker, but
+		// its outcome here is not recorded: a failure for this worker
+		if (!queue.Complete(name, ok, timer()))
+			ok = false;
+		if (telemetry)
+			telemetry->CaseDone(ok);
+		if (!ok)
+			++nfailed;
+	}
+	return nfailed;
+}
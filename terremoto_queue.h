@@ -0,0 +1,119 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_QUEUE_H
+#define TERREMOTO_QUEUE_H
+
+///////////////////////////////////////////////////
+//
+//   Work queue of cases in a shared directory, so
+//   that many terremoto processes, on several
+//   machines, can drain one sweep without a server.
+//
+//   For each case <name>:
+//     <name>.case       settings of the case (key value lines)
+//     <name>.claim      created atomically by the worker that runs it;
+//                       ("worker attempt"); its modification time is
+//                       the lease heartbeat
+//     <name>.takeover   held while a worker takes an expired claim over
+//     <name>.results/   output files of the case
+//     <name>.done       outcome, written when the case ends
+//
+//   A claim whose heartbeat is older than the lease (a crashed
+//   worker) expires, and the case is retried by another worker.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "terremoto_run.h"
+#include "terremoto_telemetry.h"
+
+
+/// Write the settings of a case as  key value  lines.
+
+void write_case(std::ostream& out, const RunCase& mcase);
+
+/// Read the settings of a case written by write_case(); keys not given
+/// keep their value in mcase. Besides the RunCase keys, a case may give
+/// 'use_barrier 0|1' instead of the records: the first displacement
+/// record of that variant in the library is used, with its companion.
+/// Returns false, and logs the reason, on an unknown key or a missing record.
+
+bool read_case(std::istream& in, RunCase& mcase, const RecordLibrary& library);
+
+
+/// A work-queue directory.
+
+class WorkQueue
+{
+public:
+	WorkQueue(const std::string& mdirectory, double mlease = 300, int mmax_attempts = 3);
+
+		/// Add a case to the queue, as <label>.case
+	bool Enqueue(const RunCase& mcase);
+
+		/// Claim the first case that is neither done nor claimed (or whose
+		/// claim expired). Returns false if there is nothing left to claim.
+		/// Cases abandoned after too many attempts, or that cannot be read,
+		/// are recorded as failed on the way (see TakeFailed()).
+	bool Claim(std::string& name, RunCase& mcase, const RecordLibrary& library);
+
+		/// Number of cases that Claim() recorded as failed without returning
+		/// them, since the last call.
+	int TakeFailed();
+
+		/// Renew the lease of a claimed case, if the claim is still this worker's.
+	void Heartbeat(const std::string& name);
+
+		/// Record the outcome of a claimed case, and release the claim; nothing
+		/// if the claim expired and was taken over by another worker, in which
+		/// case it returns false.
+	bool Complete(const std::string& name, bool ok, double runtime);
+
+		/// Number of cases not done yet.
+	int CountPending() const;
+
+	double GetLease() const { return lease; }
+
+private:
+	std::string Path(const std::string& name, const char* suffix) const;
+
+		// Current time of the file system of the queue (not of this machine,
+		// whose clock may differ from the other workers').
+	long FileSystemNow() const;
+
+		// Owner and attempt number of the claim of a case; false if there is none.
+	bool ReadClaim(const std::string& name, std::string& owner, int& attempt) const;
+	bool OwnsClaim(const std::string& name) const;
+
+	bool TakeOverExpired(const std::string& name, int& attempt);
+
+	std::string directory;
+	double lease;
+	int max_attempts;
+	std::string worker_id;
+	int nfailed;	// failed in Claim(), not taken yet
+};
+
+
+/// Run the cases of a queue until none is left to claim, renewing the
+/// lease of the running case from a separate thread. If telemetry is
+/// given, the progress is published on its worker 0.
+/// Returns the number of failed cases, including the cases abandoned or
+/// unreadable, and those whose claim was lost while they ran.
+
+int run_queue(WorkQueue& queue, const RecordLibrary& library, Telemetry* telemetry = 0);
+
+
+#endif
@@ -0,0 +1,467 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "core/ChLog.h"
+#include "motion_functions/ChFunction_Recorder.h"
+
+#include "terremoto_records.h"
+#include "terremoto_files.h"
+
+using namespace chrono;
+
+
+static const char  record_magic[8] = {'T','R','M','R','E','C','1','\0'};
+static const char* index_filename  = "records.idx";
+
+
+// Decode quantity and direction from a name like "No_Barrier_Uh".
+// Returns false if the name does not follow the <anything>_<Q><d> convention.
+
+static bool decode_record_name(const std::string& name, RecordInfo& info)
+{
+	size_t n = name.size();
+	if (n < 3 || name[n-3] != '_')
+		return false;
+	char q = name[n-2];
+	char d = name[n-1];
+	if ((q != 'U' && q != 'V' && q != 'A') || (d != 'h' && d != 'v'))
+		return false;
+	info.name      = name;
+	info.quantity  = q;
+	info.direction = d;
+	info.barrier   = (name.find("Barrier") != std::string::npos) && (name.find("No_Barrier") == std::string::npos);
+	return true;
+}
+
+
+
+bool MotionRecord::LoadText(const std::string& filename)
+{
+	time.clear();
+	value.clear();
+	uniform = false;
+
+	// Slurp the whole file, then parse it in place: much faster than
+	// stream extraction for records of many thousands of samples.
+	FILE* f = fopen(filename.c_str(), "rb");
+	if (!f)
+		return false;
+	std::vector<char> buffer;
+	char chunk[65536];
+	size_t nread;
+	while ((nread = fread(chunk, 1, sizeof(chunk), f)) > 0)
+		buffer.insert(buffer.end(), chunk, chunk + nread);
+	fclose(f);
+	buffer.push_back('\0');
+
+	const char* p = &buffer[0];
+	char* end;
+	while (true)
+	{
+		double t = strtod(p, &end);
+		if (end == p)
+			break;
+		p = end;
+		double v = strtod(p, &end);
+		if (end == p)
+			break;
+		p = end;
+		time.push_back(t);
+		value.push_back(v);
+	}
+	if (value.size() < 2)
+		return false;
+
+	// Detect constant sampling step, to store times implicitly.
+	t0 = time.front();
+	dt = (time.back() - time.front()) / (double)(time.size() - 1);
+	uniform = (dt > 0);
+	for (size_t i = 1; i < time.size() && uniform; ++i)
+		if (fabs(time[i] - (t0 + dt * (double)i)) > 1e-6 * dt)
+			uniform = false;
+	if (uniform)
+		time.clear();
+
+	return true;
+}
+
+bool MotionRecord::LoadBinary(const std::string& filename)
+{
+	FILE* f = fopen(filename.c_str(), "rb");
+	if (!f)
+		return false;
+	char magic[8];
+	int  n = 0;
+	int  is_uniform = 0;
+	bool ok = (fread(magic, 1, 8, f) == 8) && (memcmp(magic, record_magic, 8) == 0) &&
+			  (fread(&n, sizeof(int), 1, f) == 1) &&
+			  (fread(&is_uniform, sizeof(int), 1, f) == 1) &&
+			  (fread(&t0, sizeof(double), 1, f) == 1) &&
+			  (fread(&dt, sizeof(double), 1, f) == 1) &&
+			  (n > 0);
+	if (ok)
+	{
+		uniform = (is_uniform != 0);
+		value.resize(n);
+		if (uniform)
+			time.clear();
+		else
+		{
+			time.resize(n);
+			ok = (fread(&time[0], sizeof(double), n, f) == (size_t)n);
+		}
+		ok = ok && (fread(&value[0], sizeof(double), n, f) == (size_t)n);
+	}
+	fclose(f);
+	return ok;
+}
+
+bool MotionRecord::SaveBinary(const std::string& filename) const
+{
+	FILE* f = fopen(filename.c_str(), "wb");
+	if (!f)
+		return false;
+	int n = (int)value.size();
+	int is_uniform = uniform ? 1 : 0;
+	bool ok = (fwrite(record_magic, 1, 8, f) == 8) &&
+			  (fwrite(&n, sizeof(int), 1, f) == 1) &&
+			  (fwrite(&is_uniform, sizeof(int), 1, f) == 1) &&
+			  (fwrite(&t0, sizeof(double), 1, f) == 1) &&
+			  (fwrite(&dt, sizeof(double), 1, f) == 1);
+	if (ok && !uniform)
+		ok = (fwrite(&time[0], sizeof(double), n, f) == (size_t)n);
+	ok = ok && (fwrite(&value[0], sizeof(double), n, f) == (size_t)n);
+	fclose(f);
+	return ok;
+}
+
+
+
+bool RecordQuery::Parse(const std::string& query)
+{
+	terms.clear();
+	std::istringstream tokens(query);
+	std::string token;
+	while (tokens >> token)
+	{
+		size_t pos = token.find_first_of("=<>");
+		if (pos == std::string::npos || pos == 0)
+		{
+			GetLog() << "Bad term '" << token.c_str() << "' in record query \n";
+			return false;
+		}
+		size_t vpos = token.find_first_not_of("=<>", pos);
+		Term term;
+		term.key   = token.substr(0, pos);
+		term.op    = token.substr(pos, (vpos == std::string::npos ? token.size() : vpos) - pos);
+		term.value = (vpos == std::string::npos) ? "" : token.substr(vpos);
+		if (term.op != "=" && term.op != "<" && term.op != ">" && term.op != "<=" && term.op != ">=")
+		{
+			GetLog() << "Bad operator in term '" << token.c_str() << "' of record query \n";
+			return false;
+		}
+		terms.push_back(term);
+	}
+	return true;
+}
+
+static bool compare_number(double a, const std::string& op, double b)
+{
+	if (op == "<")  return a <  b;
+	if (op == ">")  return a >  b;
+	if (op == "<=") return a <= b;
+	if (op == ">=") return a >= b;
+	return fabs(a - b) <= 1e-9 * std::max(1.0, fabs(b));
+}
+
+bool RecordQuery::Matches(const RecordInfo& info) const
+{
+	for (size_t i = 0; i < terms.size(); ++i)
+	{
+		const Term& t = terms[i];
+		double num = atof(t.value.c_str());
+		bool ok = true;
+		if      (t.key == "name")      ok = info.name.find(t.value) != std::string::npos;
+		else if (t.key == "set")       ok = info.set.find(t.value) != std::string::npos;
+		else if (t.key == "barrier")   ok = (info.barrier == (num != 0 || t.value == "true" || t.value == "yes"));
+		else if (t.key == "quantity")  ok = !t.value.empty() && info.quantity == t.value[0];
+		else if (t.key == "direction") ok = !t.value.empty() && info.direction == t.value[0];
+		else if (t.key == "dt")        ok = compare_number(info.dt, t.op, num);
+		else if (t.key == "duration")  ok = compare_number(info.duration, t.op, num);
+		else if (t.key == "pga")       ok = compare_number(info.pga, t.op, num);
+		else if (t.key == "peak")      ok = compare_number(info.peak, t.op, num);
+		else
+			ok = false;
+		if (!ok)
+			return false;
+	}
+	return true;
+}
+
+
+
+bool RecordLibrary::Open(const std::string& mdirectory)
+{
+	directory = mdirectory;
+	records.clear();
+	LoadIndex();
+
+	// Scan the root and its subdirectories for records, ingesting the
+	// ones that are not in the index or that changed since.
+	std::vector<std::string> files, subdirs;
+	list_directory(directory, files, subdirs);
+	std::vector< std::pair<std::string, std::string> > candidates; // (set, file)
+	for (size_t i = 0; i < files.size(); ++i)
+		candidates.push_back(std::make_pair(std::string(""), files[i]));
+	for (size_t j = 0; j < subdirs.size(); ++j)
+	{
+		std::vector<std::string> subfiles, subsubdirs;
+		list_directory(join_path(directory, subdirs[j]), subfiles, subsubdirs);
+		for (size_t i = 0; i < subfiles.size(); ++i)
+			candidates.push_back(std::make_pair(subdirs[j], subfiles[i]));
+	}
+
+	std::vector<RecordInfo> updated;
+	bool changed = false;
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		const std::string& set  = candidates[i].first;
+		const std::string& file = candidates[i].second;
+		if (file.size() < 5 || file.compare(file.size() - 4, 4, ".txt") != 0)
+			continue;
+		RecordInfo info;
+		if (!decode_record_name(file.substr(0, file.size() - 4), info))
+			continue;
+		std::string relpath = set.empty() ? file : join_path(set, file);
+
+		const RecordInfo* indexed = 0;
+		for (size_t k = 0; k < records.size() && !indexed; ++k)
+			if (records[k].name == info.name && records[k].set == set)
+				indexed = &records[k];
+		if (indexed && indexed->mtime == file_mtime(join_path(directory, relpath)) &&
+			file_mtime(BinaryPath(*indexed)) >= 0)
+		{
+			updated.push_back(*indexed);
+			continue;
+		}
+		if (Ingest(relpath, set, info))
+		{
+			updated.push_back(info);
+			changed = true;
+		}
+	}
+	if (updated.size() != records.size())
+		changed = true;
+	records = updated;
+
+	if (changed)
+		SaveIndex();
+
+	GetLog() << "Record library " << directory.c_str() << ": " << (int)records.size() << " records \n";
+	return true;
+}
+
+bool RecordLibrary::Rebuild()
+{
+	remove(join_path(directory, index_filename).c_str());
+	return Open(directory);
+}
+
+bool RecordLibrary::Ingest(const std::string& relpath, const std::string& set, RecordInfo& info) const
+{
+	std::string filename = join_path(directory, relpath);
+	MotionRecord record;
+	if (!record.LoadText(filename))
+	{
+		GetLog() << "  Cannot ingest record " << filename.c_str() << "\n";
+		return false;
+	}
+	info.set       = set;
+	info.path      = relpath;
+	info.n_samples = (int)record.GetNsamples();
+	info.duration  = record.GetTime(record.GetNsamples() - 1) - record.GetTime(0);
+	info.dt        = record.uniform ? record.dt : record.GetTime(1) - record.GetTime(0);
+	info.mtime     = file_mtime(filename);
+
+	// Peak of the recorded quantity, and PGA by finite differences
+	// of displacement or speed records.
+	info.peak = 0;
+	info.pga  = 0;
+	for (size_t i = 0; i < record.GetNsamples(); ++i)
+	{
+		info.peak = std::max(info.peak, fabs(record.value[i]));
+		double acc = 0;
+		if (info.quantity == 'A')
+			acc = record.value[i];
+		else if (info.quantity == 'V' && i > 0)
+			acc = (record.value[i] - record.value[i-1]) / (record.GetTime(i) - record.GetTime(i-1));
+		else if (info.quantity == 'U' && i > 0 && i + 1 < record.GetNsamples())
+		{
+			double h1 = record.GetTime(i) - record.GetTime(i-1);
+			double h2 = record.GetTime(i+1) - record.GetTime(i);
+			acc = 2.0 * ( (record.value[i+1] - record.value[i]) / h2
+						- (record.value[i] - record.value[i-1]) / h1 ) / (h1 + h2);
+		}
+		info.pga = std::max(info.pga, fabs(acc));
+	}
+
+	if (!record.SaveBinary(BinaryPath(info)))
+	{
+		GetLog() << "  Cannot write binary record " << BinaryPath(info).c_str() << "\n";
+		return false;
+	}
+	GetLog() << "  Ingested record " << relpath.c_str() << "\n";
+	return true;
+}
+
+bool RecordLibrary::LoadIndex()
+{
+	std::ifstream in(join_path(directory, index_filename).c_str());
+	if (!in.good())
+		return false;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+		// tab-separated, because set names may contain spaces
+		std::vector<std::string> fields;
+		std::istringstream ls(line);
+		std::string field;
+		while (std::getline(ls, field, '\t'))
+			fields.push_back(field);
+		if (fields.size() != 12)
+			continue;
+		RecordInfo info;
+		info.name      = fields[0];
+		info.set       = fields[1];
+		info.path      = fields[2];
+		info.barrier   = atoi(fields[3].c_str()) != 0;
+		info.quantity  = fields[4].empty() ? 'U' : fields[4][0];
+		info.direction = fields[5].empty() ? 'h' : fields[5][0];
+		info.n_samples = atoi(fields[6].c_str());
+		info.dt        = atof(fields[7].c_str());
+		info.duration  = atof(fields[8].c_str());
+		info.peak      = atof(fields[9].c_str());
+		info.pga       = atof(fields[10].c_str());
+		info.mtime     = atol(fields[11].c_str());
+		records.push_back(info);
+	}
+	return true;
+}
+
+bool RecordLibrary::SaveIndex() const
+{
+	std::ofstream out(join_path(directory, index_filename).c_str());
+	if (!out.good())
+	{
+		GetLog() << "Cannot write record index in " << directory.c_str() << "\n";
+		return false;
+	}
+	out.precision(10);
+	out << "# name\tset\tpath\tbarrier\tquantity\tdirection\tn_samples\tdt\tduration\tpeak\tpga\tmtime\n";
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		const RecordInfo& r = records[i];
+		out << r.name << "\t" << r.set << "\t" << r.path << "\t" << (r.barrier ? 1 : 0) << "\t"
+			<< r.quantity << "\t" << r.direction << "\t" << r.n_samples << "\t" << r.dt << "\t"
+			<< r.duration << "\t" << r.peak << "\t" << r.pga << "\t" << r.mtime << "\n";
+	}
+	return true;
+}
+
+std::string RecordLibrary::BinaryPath(const RecordInfo& info) const
+{
+	std::string relpath = info.path.substr(0, info.path.size() - 4) + ".bin";
+	return join_path(directory, relpath);
+}
+
+std::vector<const RecordInfo*> RecordLibrary::Select(const RecordQuery& query) const
+{
+	std::vector<const RecordInfo*> selection;
+	for (size_t i = 0; i < records.size(); ++i)
+		if (query.Matches(records[i]))
+			selection.push_back(&records[i]);
+	return selection;
+}
+
+std::vector<const RecordInfo*> RecordLibrary::Select(const std::string& query) const
+{
+	RecordQuery mquery;
+	if (!mquery.Parse(query))
+		return std::vector<const RecordInfo*>();
+	return Select(mquery);
+}
+
+const RecordInfo* RecordLibrary::Find(const std::string& name, const std::string& set) const
+{
+	for (size_t i = 0; i < records.size(); ++i)
+		if (records[i].name == name && (set.empty() || records[i].set == set))
+			return &records[i];
+	return 0;
+}
+
+const RecordInfo* RecordLibrary::FindCompanion(const RecordInfo& info) const
+{
+	std::string name = info.name;
+	name[name.size() - 1] = (info.direction == 'h') ? 'v' : 'h';
+	return Find(name, info.set);
+}
+
+const RecordInfo* RecordLibrary::FindVariant(const RecordInfo& info) const
+{
+	std::string name = info.name;
+	if (info.barrier)
+	{
+		size_t pos = name.find("Barrier");
+		name.replace(pos, 7, "No_Barrier");
+	}
+	else
+	{
+		size_t pos = name.find("No_Barrier");
+		if (pos == std::string::npos)
+			return 0;
+		name.replace(pos, 10, "Barrier");
+	}
+	return Find(name, info.set);
+}
+
+bool RecordLibrary::Load(const RecordInfo& info, MotionRecord& record) const
+{
+	if (record.LoadBinary(BinaryPath(info)))
+		return true;
+	// binary form missing or damaged: fall back to the text record
+	return record.LoadText(join_path(directory, info.path));
+}
+
+ChFunction* RecordLibrary::CreateMotion(const RecordInfo& info, double t_offset, double factor) const
+{
+	MotionRecord record;
+	if (!Load(info, record))
+	{
+		GetLog() << "Cannot load record " << info.path.c_str() << "\n";
+		return 0;
+	}
+
+	ChFunction_Recorder* mrecorder = new ChFunction_Recorder;
+	for (size_t i = 0; i < record.GetNsamples(); ++i)
+		mrecorder->AddPoint(record.GetTime(i) + t_offset, record.value[i] * factor);
+
+	return mrecorder;
+}
@@ -0,0 +1,168 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_RECORDS_H
+#define TERREMOTO_RECORDS_H
+
+///////////////////////////////////////////////////
+//
+//   Library of ground-motion records.
+//
+//   A library is a directory (with optional
+//   one-level subdirectories, one per set of records)
+//   of two-column time/value text files named as
+//       <anything>_<Q><d>.txt
+//   where Q is U, V or A (displacement, speed,
+//   acceleration) and d is h or v (horizontal,
+//   vertical). Files whose name starts with, or
+//   contains, "Barrier" but not "No_Barrier" are
+//   the barrier variants.
+//
+//   Each text record is parsed only once: its
+//   metadata goes in the index file 'records.idx'
+//   in the library directory, and its samples
+//   in a compact binary file '<record>.bin' that
+//   is what runs really load.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "motion_functions/ChFunction_Base.h"
+
+
+/// Samples of one ground-motion record.
+
+class MotionRecord
+{
+public:
+	MotionRecord() : uniform(false), t0(0), dt(0) {}
+
+	size_t GetNsamples() const { return value.size(); }
+	double GetTime(size_t i) const { return uniform ? t0 + dt * (double)i : time[i]; }
+
+		/// Parse a two-column time/value text file. Returns false if the
+		/// file cannot be read or holds less than two samples.
+	bool LoadText(const std::string& filename);
+
+		/// Load/save the compact binary form.
+	bool LoadBinary(const std::string& filename);
+	bool SaveBinary(const std::string& filename) const;
+
+	std::vector<double> time;	// empty if uniform
+	std::vector<double> value;
+	bool   uniform;				// true if sampled at constant step dt from t0
+	double t0;
+	double dt;
+};
+
+
+/// Metadata of a record in the library, as stored in the index.
+
+class RecordInfo
+{
+public:
+	RecordInfo() : barrier(false), quantity('U'), direction('h'), n_samples(0), dt(0), duration(0), peak(0), pga(0), mtime(0) {}
+
+	std::string name;		// file name without extension, ex. "No_Barrier_Uh"
+	std::string set;		// subdirectory of the library, "" if in the root
+	std::string path;		// text file, relative to the library directory
+	bool   barrier;
+	char   quantity;		// 'U' displacement, 'V' speed, 'A' acceleration
+	char   direction;		// 'h' horizontal, 'v' vertical
+	int    n_samples;
+	double dt;				// sampling step (the first one, if not uniform)
+	double duration;
+	double peak;			// max abs value of the recorded quantity
+	double pga;				// peak ground acceleration, differentiating U and V records
+	long   mtime;			// modification time of the text file when ingested
+};
+
+
+/// A selection of records, ex. parsed from  "barrier=0 quantity=U direction=h pga>2.5"
+/// Keys are  name set barrier quantity direction dt duration pga peak ;
+/// name and set match as substrings, the numeric keys accept = < > <= >= .
+
+class RecordQuery
+{
+public:
+	RecordQuery() {}
+
+		/// Parse the query string; returns false, and logs the reason,
+		/// on a malformed term.
+	bool Parse(const std::string& query);
+
+	bool Matches(const RecordInfo& info) const;
+
+private:
+	struct Term
+	{
+		std::string key;
+		std::string op;
+		std::string value;
+	};
+	std::vector<Term> terms;
+};
+
+
+/// Indexed collection of ground-motion records in a directory.
+
+class RecordLibrary
+{
+public:
+		/// Open the library in 'directory'. Loads the index if present, then
+		/// ingests the text records that are new or modified since the
+		/// index was written, and saves the index back if anything changed.
+	bool Open(const std::string& directory);
+
+		/// Drop the index and re-ingest all records.
+	bool Rebuild();
+
+	const std::string& GetDirectory() const { return directory; }
+	const std::vector<RecordInfo>& GetRecords() const { return records; }
+
+		/// All records matching the query, in index order.
+	std::vector<const RecordInfo*> Select(const RecordQuery& query) const;
+	std::vector<const RecordInfo*> Select(const std::string& query) const;
+
+		/// The record with given name (and set, if not empty), or 0.
+	const RecordInfo* Find(const std::string& name, const std::string& set = "") const;
+
+		/// The record of the same set, variant and quantity of 'info' but for
+		/// the other direction, ex. No_Barrier_Uv for No_Barrier_Uh; or 0.
+	const RecordInfo* FindCompanion(const RecordInfo& info) const;
+
+		/// The record of the same set, quantity and direction of 'info' but for
+		/// the other variant, ex. No_Barrier_Uh for Barrier_Uh; or 0.
+	const RecordInfo* FindVariant(const RecordInfo& info) const;
+
+		/// Load the samples of a record, from its binary form.
+	bool Load(const RecordInfo& info, MotionRecord& record) const;
+
+		/// Create the motion function of a record, shifted by t_offset and
+		/// scaled by factor, as create_motion() does for text files.
+		/// The returned function is owned by the caller; 0 if the record
+		/// cannot be loaded.
+	chrono::ChFunction* CreateMotion(const RecordInfo& info, double t_offset = 0, double factor = 1.0) const;
+
+private:
+	bool Ingest(const std::string& relpath, const std::string& set, RecordInfo& info) const;
+	bool LoadIndex();
+	bool SaveIndex() const;
+	std::string BinaryPath(const RecordInfo& info) const;
+
+	std::string directory;
+	std::vector<RecordInfo> records;
+};
+
+
+#endif
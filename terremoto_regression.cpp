@@ -0,0 +1,216 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "core/ChLog.h"
+#include "core/ChTimer.h"
+
+#include "terremoto_regression.h"
+#include "terremoto_files.h"
+
+using namespace chrono;
+
+
+// Number of values per step in the trajectories:  t  brick_1 (x y z)  brick_2 (x y z)
+static const int trajectory_stride = 7;
+
+
+static std::string golden_filename(const RunCase& mcase, const RegressionSettings& settings)
+{
+	return join_path(settings.golden_dir, mcase.label + ".golden");
+}
+
+// Run a case in the deterministic mode, without output files, keeping the
+// brick displacements after t_save in memory. Returns the runtime, or -1 if
+// the case could not be set up.
+
+static double run_trajectory(const RunCase& mcase, const RecordLibrary& library, std::vector<double>& trajectory)
+{
+	RunCase dcase = mcase;
+	dcase.deterministic = true;
+	dcase.save_full_dumps = false;
+
+	trajectory.clear();
+
+	ChTimer<double> timer;
+	timer.start();
+
+	ChSystem mphysicalSystem;
+	TempleModel model;
+	if (!setup_case(mphysicalSystem, model, dcase, library))
+		return -1;
+
+	RunMonitor monitor(mphysicalSystem, model, dcase);
+
+	while (mphysicalSystem.GetChTime() <= dcase.t_end)
+	{
+		mphysicalSystem.DoStepDynamics(dcase.timestep);
+		monitor.Update();
+
+		double time = mphysicalSystem.GetChTime();
+		if (time < dcase.t_save)
+			continue;
+		const ChVector<>& d1 = monitor.GetBrick1Displacement();
+		const ChVector<>& d2 = monitor.GetBrick2Displacement();
+		double row[trajectory_stride] = { time, d1.x, d1.y, d1.z, d2.x, d2.y, d2.z };
+		trajectory.insert(trajectory.end(), row, row + trajectory_stride);
+	}
+
+	timer.stop();
+	return timer();
+}
+
+
+bool record_golden(const RunCase& mcase, const RecordLibrary& library, const RegressionSettings& settings)
+{
+	GetLog() << "Recording golden trajectory of " << mcase.label.c_str() << "\n";
+
+	std::vector<double> trajectory;
+	double runtime = run_trajectory(mcase, library, trajectory);
+	if (runtime < 0)
+		return false;
+
+	if (!make_directory(settings.golden_dir))
+	{
+		GetLog() << "Cannot create " << settings.golden_dir.c_str() << "\n";
+		return false;
+	}
+	std::string filename = golden_filename(mcase, settings);
+	std::ofstream out(filename.c_str());
+	if (!out.good())
+	{
+		GetLog() << "Cannot write " << filename.c_str() << "\n";
+		return false;
+	}
+	out.precision(17);
+	out << "# runtime " << runtime << "\n";
+	out << "# t  brick_1 (x y z)  brick_2 (x y z)\n";
+	for (size_t i = 0; i < trajectory.size(); i += trajectory_stride)
+	{
+		out << trajectory[i];
+		for (int k = 1; k < trajectory_stride; ++k)
+			out << " " << trajectory[i + k];
+		out << "\n";
+	}
+	return true;
+}
+
+
+static bool load_golden(const std::string& filename, std::vector<double>& trajectory, double& runtime)
+{
+	std::ifstream in(filename.c_str());
+	if (!in.good())
+		return false;
+	trajectory.clear();
+	runtime = 0;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.empty())
+			continue;
+		if (line[0] == '#')
+		{
+			sscanf(line.c_str(), "# runtime %lf", &runtime);
+			continue;
+		}
+		std::istringstream fields(line);
+		double v;
+		int nfields = 0;
+		while (fields >> v)
+		{
+			trajectory.push_back(v);
+			++nfields;
+		}
+		if (nfields != trajectory_stride)
+			return false;
+	}
+	return true;
+}
+
+bool check_regression(const RunCase& mcase, const RecordLibrary& library, const RegressionSettings& settings, RegressionResult& result)
+{
+	GetLog() << "Checking " << mcase.label.c_str() << "\n";
+
+	result = RegressionResult();
+	result.label = mcase.label;
+
+	std::vector<double> trajectory;
+	result.runtime = run_trajectory(mcase, library, trajectory);
+	if (result.runtime < 0)
+		return false;
+
+	std::vector<double> golden;
+	if (!load_golden(golden_filename(mcase, settings), golden, result.golden_runtime))
+	{
+		GetLog() << "  no valid golden trajectory in " << golden_filename(mcase, settings).c_str() << "\n";
+		return true;
+	}
+	result.found = true;
+
+	// A different number of steps, or steps at different times, are
+	// reported as an infinite error.
+	if (golden.size() != trajectory.size())
+	{
+		result.max_error_1 = result.max_error_2 = HUGE_VAL;
+		return true;
+	}
+	for (size_t i = 0; i < trajectory.size(); i += trajectory_stride)
+	{
+		if (fabs(trajectory[i] - golden[i]) > 0.5 * mcase.timestep)
+		{
+			result.max_error_1 = result.max_error_2 = HUGE_VAL;
+			return true;
+		}
+		ChVector<> e1(trajectory[i+1] - golden[i+1], trajectory[i+2] - golden[i+2], trajectory[i+3] - golden[i+3]);
+		ChVector<> e2(trajectory[i+4] - golden[i+4], trajectory[i+5] - golden[i+5], trajectory[i+6] - golden[i+6]);
+		result.max_error_1 = std::max(result.max_error_1, e1.Length());
+		result.max_error_2 = std::max(result.max_error_2, e2.Length());
+	}
+	return true;
+}
+
+
+int report_regression(const std::vector<RegressionResult>& results, const RegressionSettings& settings)
+{
+	std::ofstream out("regression.dat");
+	out << "# label  max_error_brick_1  max_error_brick_2  runtime  golden_runtime  runtime_ratio  status\n";
+
+	int nfailed = 0;
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const RegressionResult& r = results[i];
+		const char* status = "ok";
+		if (!r.found)
+			status = "NO_GOLDEN";
+		else if (!r.Accurate(settings))
+			status = "INACCURATE";
+		else if (!r.Fast(settings))
+			status = "SLOW";
+		if (!r.found || !r.Accurate(settings) || !r.Fast(settings))
+			++nfailed;
+
+		double ratio = (r.golden_runtime > 0) ? r.runtime / r.golden_runtime : 0;
+		out << r.label << " " << r.max_error_1 << " " << r.max_error_2 << " "
+			<< r.runtime << " " << r.golden_runtime << " " << ratio << " " << status << "\n";
+
+		char line[500];
+		sprintf(line, "%-40s  err %10.3g %10.3g  runtime %8.2f s (golden %8.2f s, x%5.2f)  %s\n",
+				r.label.c_str(), r.max_error_1, r.max_error_2, r.runtime, r.golden_runtime, ratio, status);
+		GetLog() << line;
+	}
+	GetLog() << (int)(results.size() - nfailed) << " of " << (int)results.size() << " cases passed \n";
+	return nfailed;
+}
@@ -0,0 +1,81 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_REGRESSION_H
+#define TERREMOTO_REGRESSION_H
+
+///////////////////////////////////////////////////
+//
+//   Regression checks: cases are run in the
+//   deterministic mode and the trajectories of the
+//   plotted bricks are compared with stored golden
+//   trajectories, together with the runtime.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "terremoto_run.h"
+
+
+/// Settings of the regression checks.
+
+class RegressionSettings
+{
+public:
+	RegressionSettings() : golden_dir("golden"), tolerance(1e-6), runtime_tolerance(1.5) {}
+
+	std::string golden_dir;		// directory of the golden trajectories, one <label>.golden file per case
+	double tolerance;			// max difference of the brick displacements from the golden ones, m
+	double runtime_tolerance;	// max ratio of the runtime to the golden runtime
+};
+
+
+/// Outcome of the regression check of one case.
+
+class RegressionResult
+{
+public:
+	RegressionResult() : found(false), max_error_1(0), max_error_2(0), runtime(0), golden_runtime(0) {}
+
+	bool Accurate(const RegressionSettings& settings) const { return found && max_error_1 <= settings.tolerance && max_error_2 <= settings.tolerance; }
+	bool Fast(const RegressionSettings& settings) const { return found && runtime <= settings.runtime_tolerance * golden_runtime; }
+
+	std::string label;
+	bool   found;				// false if there is no (valid) golden trajectory for the case
+	double max_error_1;			// max norm of the difference of the brick 1 displacement, m
+	double max_error_2;			// max norm of the difference of the brick 2 displacement, m
+	double runtime;				// s
+	double golden_runtime;		// s
+};
+
+
+/// Run a case in the deterministic mode and store the trajectories of the
+/// plotted bricks, and the runtime, as its golden trajectory.
+/// Returns false if the case could not be run or the file not written.
+
+bool record_golden(const RunCase& mcase, const RecordLibrary& library, const RegressionSettings& settings);
+
+
+/// Run a case in the deterministic mode and compare it with its golden
+/// trajectory. Returns false if the case could not be run.
+
+bool check_regression(const RunCase& mcase, const RecordLibrary& library, const RegressionSettings& settings, RegressionResult& result);
+
+
+/// Print the results of the checks as a table, in the log and in
+/// regression.dat. Returns the number of failed cases.
+
+int report_regression(const std::vector<RegressionResult>& results, const RegressionSettings& settings);
+
+
+#endif
@@ -0,0 +1,764 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cassert>
+#include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include "motion_functions/ChFunction_Base.h"
+#include "lcp/ChLcpIterativeSolver.h"
+
+#include "terremoto_run.h"
+#include "terremoto_files.h"
+#include "terremoto_stream.h"
+
+using namespace chrono;
+
+
+RunCase::RunCase()
+{
+	label = "";
+	output_dir = "";
+	record_set = "";
+	record_h = "No_Barrier_Uh";
+	record_v = "No_Barrier_Uv";
+	record_multi = "";
+	stream_h = "";
+	stream_v = "";
+	stream_window = 4096;
+	ampl_factor = 7;
+	time_offset = 5.0;
+	t_save = 4.5;
+	t_end = 9;
+	timestep = 0.005;
+	simple_temple = true;
+	save_full_dumps = true;
+	deterministic = false;
+	spectra_T_min = 0.02;
+	spectra_T_max = 5.0;
+	spectra_n_periods = 100;
+	spectra_damping = 0.05;
+}
+
+
+
+// The motion function of a record, raw or preprocessed depending on the case settings;
+// 0 if the record cannot be loaded
+
+static ChFunction* create_case_motion(const RecordInfo& info, const RunCase& mcase, const RecordLibrary& library)
+{
+	if (!mcase.preprocessing.enabled)
+	{
+		// imposed as sampled: only a displacement record can drive the table
+		if (info.quantity != 'U')
+		{
+			GetLog() << "Record " << info.name.c_str() << " is not a displacement: it needs the preprocessing, not --raw-motion \n";
+			return 0;
+		}
+		return library.CreateMotion(info, mcase.time_offset, mcase.ampl_factor);
+	}
+
+	MotionRecord record;
+	if (!library.Load(info, record))
+	{
+		GetLog() << "Cannot load record " << info.path.c_str() << "\n";
+		return 0;
+	}
+	double motion_step = mcase.timestep * mcase.preprocessing.step_multiple;
+	return create_preprocessed_motion(record, info.quantity, mcase.preprocessing, motion_step, mcase.time_offset, mcase.ampl_factor);
+}
+
+bool setup_case(ChSystem& mphysicalSystem,
+				TempleModel& model,
+				const RunCase& mcase,
+				const RecordLibrary& library,
+				MemoryAccount* memory)
+{
+	if (memory)
+	{
+		// before the material table sets its callback on the container
+		MemoryScope scope(memory, MEMORY_CONTACTS);
+		mphysicalSystem.ChangeContactContainer(new AccountedContactContainer);
+	}
+	{
+		MemoryScope scope(memory, MEMORY_BODIES, true);
+		if (mcase.material_pairs.empty())
+			create_temple(mphysicalSystem, model, mcase.simple_temple, mcase.material);
+		else
+		{
+			MaterialTable materials(mcase.material);
+			for (size_t i = 0; i < mcase.material_pairs.size(); ++i)
+				materials.SetPair(mcase.material_pairs[i]);
+			create_temple(mphysicalSystem, model, mcase.simple_temple, mcase.material, &materials);
+		}
+	}
+	set_solver_settings(mphysicalSystem, mcase.deterministic);
+
+	MemoryScope scope(memory, MEMORY_RECORDS, true);
+
+	// All the components from one combined record
+	if (!mcase.record_multi.empty())
+	{
+		std::shared_ptr<MultiComponentMotion> motion(new MultiComponentMotion);
+		if (!motion->Load(mcase.record_multi, mcase.time_offset, mcase.ampl_factor))
+		{
+			GetLog() << "Cannot load combined record " << mcase.record_multi.c_str() << "\n";
+			return false;
+		}
+		set_link_motion(*model.link_earthquake, motion);
+		return true;
+	}
+
+	// Define the horizontal motion, on x:
+	//ChFunction_Sine* mmotion_x = new ChFunction_Sine(0,1.6,0.5); // phase freq ampl, carachteristics of input motion
+	if (!mcase.stream_h.empty())
+	{
+		StreamingMotion* stream = new StreamingMotion(mcase.stream_h, mcase.time_offset, mcase.ampl_factor, mcase.stream_window);
+		if (!stream->IsOpen())
+		{
+			delete stream;
+			return false;
+		}
+		model.link_earthquake->SetMotion_Z(stream);
+	}
+	else
+	{
+		const RecordInfo* info_h = library.Find(mcase.record_h, mcase.record_set);
+		if (!info_h)
+		{
+			GetLog() << "Record " << mcase.record_h.c_str() << " not found in the library \n";
+			return false;
+		}
+		ChFunction* motion_h = create_case_motion(*info_h, mcase, library);
+		if (!motion_h)
+			return false;
+		model.link_earthquake->SetMotion_Z(motion_h);
+	}
+
+	// Define the vertical motion, on y:
+	if (!mcase.stream_v.empty())
+	{
+		StreamingMotion* stream = new StreamingMotion(mcase.stream_v, mcase.time_offset, mcase.ampl_factor, mcase.stream_window);
+		if (!stream->IsOpen())
+		{
+			delete stream;
+			return false;
+		}
+		model.link_earthquake->SetMotion_Y(stream);
+	}
+	else if (!mcase.record_v.empty())
+	{
+		const RecordInfo* info_v = library.Find(mcase.record_v, mcase.record_set);
+		if (!info_v)
+		{
+			GetLog() << "Record " << mcase.record_v.c_str() << " not found in the library \n";
+			return false;
+		}
+		ChFunction* motion_v = create_case_motion(*info_v, mcase, library);
+		if (!motion_v)
+			return false;
+		model.link_earthquake->SetMotion_Y(motion_v);
+	}
+
+	return true;
+}
+
+void report_memory(const MemoryAccount& memory, ChSystem& mphysicalSystem, const RunCase& mcase)
+{
+	if (!MemoryAccount::IsEnabled())
+		return;
+
+	int nbodies = mphysicalSystem.GetNbodies();
+	int ncontacts = mphysicalSystem.GetNcontacts();
+	long long bodies = memory.GetBytes(MEMORY_BODIES);
+	long long contacts = memory.GetBytes(MEMORY_CONTACTS);
+	long long simulation = memory.GetBytes(MEMORY_SIMULATION);
+	GetLog() << "Memory of " << memory.GetLabel().c_str() << ": "
+			 << (int)(memory.GetTotalBytes() >> 10) << " kB (peak " << (int)(memory.GetPeakBytes() >> 10) << " kB), "
+			 << "bodies " << (int)(bodies >> 10) << " kB (" << (nbodies ? (int)(bodies / nbodies) : 0) << " B per body), "
+			 << "records " << (int)(memory.GetBytes(MEMORY_RECORDS) >> 10) << " kB, "
+			 << "contacts " << (int)(contacts >> 10) << " kB (" << ncontacts << " contacts), "
+			 << "simulation " << (int)(simulation >> 10) << " kB, "
+			 << "arena " << (int)(memory.GetArenaBytes() >> 10) << " kB\n";
+
+	std::string memory_filename = join_path(mcase.output_dir, "memory.dat");
+	bool memory_exists = std::ifstream(memory_filename.c_str()).good();
+	std::ofstream out(memory_filename.c_str(), std::ios::app);
+	if (!memory_exists)
+		MemoryAccount::WriteHeader(out);
+	memory.WriteRecord(out);
+}
+
+
+
+// Name of the ground motion of a case, for the labels: the horizontal
+// record, or the file name of the combined record or of the stream
+
+static std::string motion_name(const RunCase& mcase)
+{
+	std::string source = !mcase.record_multi.empty() ? mcase.record_multi : mcase.stream_h;
+	if (source.empty())
+		return mcase.record_h;
+	if (source == "-")
+		return "stdin";
+	size_t slash = source.find_last_of("/\\");
+	if (slash != std::string::npos)
+		source.erase(0, slash + 1);
+	size_t dot = source.rfind('.');
+	if (dot != std::string::npos && dot > 0)
+		source.erase(dot);
+	return source;
+}
+
+
+
+// Rows of the full dumps:  t  value  speed  acceleration  for a motion, and
+// t  position  speed  acceleration (x y z each)  for a body
+
+static void set_row(std::vector<double>& row, double time, double v, double v_dt, double v_dtdt)
+{
+	row.resize(4);
+	row[0] = time;
+	row[1] = v;
+	row[2] = v_dt;
+	row[3] = v_dtdt;
+}
+
+static void set_row(std::vector<double>& row, double time, const ChVector<>& p, const ChVector<>& p_dt, const ChVector<>& p_dtdt)
+{
+	row.resize(10);
+	row[0] = time;
+	row[1] = p.x;      row[2] = p.y;      row[3] = p.z;
+	row[4] = p_dt.x;   row[5] = p_dt.y;   row[6] = p_dt.z;
+	row[7] = p_dtdt.x; row[8] = p_dtdt.y; row[9] = p_dtdt.z;
+}
+
+static void write_row(ChStreamOutAsciiFile& out, const std::vector<double>& row, int fields)
+{
+	for (size_t i = 0; i + fields <= row.size(); i += fields)
+	{
+		out << row[i];
+		for (int k = 1; k < fields; ++k)
+			out << " " << row[i + k];
+		out << "\n";
+	}
+}
+
+RunMonitor::RunMonitor(ChSystem& mphysicalSystem, TempleModel& mmodel, const RunCase& mmcase)
+	: metrics((int)mmodel.drums.size()),
+	  spectrum_x(mmcase.timestep, mmcase.spectra_T_min, mmcase.spectra_T_max, mmcase.spectra_n_periods, mmcase.spectra_damping),
+	  spectrum_y(mmcase.timestep, mmcase.spectra_T_min, mmcase.spectra_T_max, mmcase.spectra_n_periods, mmcase.spectra_damping),
+	  msystem(&mphysicalSystem),
+	  model(&mmodel),
+	  mcase(mmcase),
+	  contacts(mphysicalSystem),
+	  data_earthquake_x(0),
+	  data_earthquake_y(0),
+	  data_table(0),
+	  data_brick_1(0),
+	  data_brick_2(0),
+	  data_interfaces(0),
+	  drum_tilt(mmodel.drums.size(), 0.0),
+	  drum_tilt_previous(mmodel.drums.size(), 0.0),
+	  step_count(0),
+	  capture(0)
+{
+	// the bodies of the batched kinematics, at the indexes of the enum
+	kinematics.SetReference(model->table);
+	int index_1 = kinematics.AddBody(model->plot_brick_1);
+	int index_2 = kinematics.AddBody(model->plot_brick_2);
+	assert(index_1 == BRICK_1 && index_2 == BRICK_2);
+	(void)index_1;
+	(void)index_2;
+	for (size_t idrum = 0; idrum < model->drums.size(); ++idrum)
+	{
+		int index = kinematics.AddBody(model->drums[idrum]);
+		assert(index == FIRST_DRUM + (int)idrum);
+		(void)index;
+	}
+
+	// the components of a combined record besides Z and Y, if imposed
+	ChFunction* link_motions[NCOMPONENTS] = { model->link_earthquake->GetMotion_X(),
+											  model->link_earthquake->GetMotion_ang(),
+											  model->link_earthquake->GetMotion_ang2(),
+											  model->link_earthquake->GetMotion_ang3() };
+	static const char* component_names[NCOMPONENTS] = { "t", "rx", "ry", "rz" };
+	for (int k = 0; k < NCOMPONENTS; ++k)
+	{
+		motion_components[k] = dynamic_cast<MotionComponent*>(link_motions[k]) ? link_motions[k] : 0;
+		data_earthquake_components[k] = 0;
+	}
+
+	if (mcase.save_full_dumps)
+	{
+		data_earthquake_x = new ChStreamOutAsciiFile(OutputFilename("data_earthquake_x.dat").c_str());
+		data_earthquake_y = new ChStreamOutAsciiFile(OutputFilename("data_earthquake_y.dat").c_str());
+		data_table        = new ChStreamOutAsciiFile(OutputFilename("data_table.dat").c_str());
+		data_brick_1      = new ChStreamOutAsciiFile(OutputFilename("data_brick_1.dat").c_str());
+		data_brick_2      = new ChStreamOutAsciiFile(OutputFilename("data_brick_2.dat").c_str());
+		data_interfaces   = new ChStreamOutAsciiFile(OutputFilename("data_interfaces.dat").c_str());
+		for (int k = 0; k < NCOMPONENTS; ++k)
+			if (motion_components[k])
+				data_earthquake_components[k] = new ChStreamOutAsciiFile(OutputFilename((std::string("data_earthquake_") + component_names[k] + ".dat").c_str()).c_str());
+	}
+
+	if (mcase.save_full_dumps && mcase.capture.IsEnabled())
+	{
+		int steps_before = (int)ceil(mcase.capture.t_before / mcase.timestep);
+		int steps_after  = (int)ceil(mcase.capture.t_after / mcase.timestep);
+		capture = new EventCapture(NCHANNELS, steps_before, steps_after);
+		capture->SetChannel(CHANNEL_EARTHQUAKE_X, OutputFilename("capture_earthquake_x.dat"), EARTHQUAKE_FIELDS);
+		capture->SetChannel(CHANNEL_EARTHQUAKE_Y, OutputFilename("capture_earthquake_y.dat"), EARTHQUAKE_FIELDS);
+		for (int k = 0; k < NCOMPONENTS; ++k)
+			if (motion_components[k])
+				capture->SetChannel(CHANNEL_EARTHQUAKE_T + k, OutputFilename((std::string("capture_earthquake_") + component_names[k] + ".dat").c_str()), EARTHQUAKE_FIELDS);
+		capture->SetChannel(CHANNEL_TABLE,        OutputFilename("capture_table.dat"),        BODY_FIELDS);
+		capture->SetChannel(CHANNEL_BRICK_1,      OutputFilename("capture_brick_1.dat"),      BODY_FIELDS);
+		capture->SetChannel(CHANNEL_BRICK_2,      OutputFilename("capture_brick_2.dat"),      BODY_FIELDS);
+		capture->SetChannel(CHANNEL_INTERFACES,   OutputFilename("capture_interfaces.dat"),   INTERFACE_FIELDS);
+		capture->SetEventsFile(OutputFilename("events.dat"));
+	}
+}
+
+RunMonitor::~RunMonitor()
+{
+	delete data_earthquake_x;
+	delete data_earthquake_y;
+	delete data_table;
+	delete data_brick_1;
+	delete data_brick_2;
+	delete data_interfaces;
+	for (int k = 0; k < NCOMPONENTS; ++k)
+		delete data_earthquake_components[k];
+	delete capture;
+}
+
+std::string RunMonitor::OutputFilename(const char* name) const
+{
+	// Plain names for the interactive run, prefixed by the case label in sweeps
+	if (mcase.label.empty())
+		return join_path(mcase.output_dir, name);
+	return join_path(mcase.output_dir, mcase.label + "_" + name);
+}
+
+void RunMonitor::Update()
+{
+	ChSharedPtr<ChBody> plot_table = model->table;
+	ChFunction* mmotion_x = model->link_earthquake->GetMotion_Z();
+	ChFunction* mmotion_y = model->link_earthquake->GetMotion_Y();
+
+	double time = msystem->GetChTime();
+
+	// all the bodies relative to the table, in one batched pass
+	kinematics.Update();
+
+	if (time < mcase.t_save)
+	{
+		brick_1_initial_displacement = kinematics.GetPos(BRICK_1);
+		brick_2_initial_displacement = kinematics.GetPos(BRICK_2);
+		return;
+	}
+
+	// update metrics only after t_save to avoid the initial settlement
+
+	rel_disp_1 = kinematics.GetPos(BRICK_1) - brick_1_initial_displacement;
+	metrics.UpdateBrick1(rel_disp_1, kinematics.GetPos_dt(BRICK_1), kinematics.GetPos_dtdt(BRICK_1));
+
+	rel_disp_2 = kinematics.GetPos(BRICK_2) - brick_2_initial_displacement;
+	metrics.UpdateBrick2(rel_disp_2, kinematics.GetPos_dt(BRICK_2), kinematics.GetPos_dtdt(BRICK_2));
+
+	drum_tilt_previous.swap(drum_tilt);
+	for (unsigned int idrum = 0; idrum < model->drums.size(); ++idrum)
+	{
+		drum_tilt[idrum] = ResponseMetrics::TiltAngle(kinematics.GetRot(FIRST_DRUM + idrum));
+		metrics.UpdateDrumTilt(idrum, drum_tilt[idrum]);
+	}
+
+	double input_acc_x = mmotion_x->Get_y_dxdx(time);
+	double input_acc_y = mmotion_y->Get_y_dxdx(time);
+	metrics.UpdateInput(time, input_acc_x, input_acc_y);
+	spectrum_x.Update(input_acc_x);
+	spectrum_y.Update(input_acc_y);
+
+	double input_acc_t = motion_components[0] ? motion_components[0]->Get_y_dxdx(time) : 0.0;
+	ChVector<> input_rot(motion_components[1] ? motion_components[1]->Get_y(time) : 0.0,
+						 motion_components[2] ? motion_components[2]->Get_y(time) : 0.0,
+						 motion_components[3] ? motion_components[3]->Get_y(time) : 0.0);
+	metrics.UpdateInputComponents(time, input_acc_t, input_rot);
+
+	acc_table_h.push_back(plot_table->GetPos_dtdt().z);
+	acc_table_v.push_back(plot_table->GetPos_dtdt().y);
+	acc_brick_1_h.push_back(kinematics.abs_acc_z[BRICK_1]);
+	acc_brick_1_v.push_back(kinematics.abs_acc_y[BRICK_1]);
+	acc_brick_2_h.push_back(kinematics.abs_acc_z[BRICK_2]);
+	acc_brick_2_v.push_back(kinematics.abs_acc_y[BRICK_2]);
+
+	if (!mcase.save_full_dumps)
+		return;
+
+	// The rows of this step, written at the base rate, and kept at full
+	// rate for the event capture
+	bool base_step = (step_count++ % std::max(mcase.capture.decimation, 1)) == 0;
+	if (!base_step && !capture)
+		return;
+
+	set_row(rows[CHANNEL_EARTHQUAKE_X], time, mmotion_x->Get_y(time), mmotion_x->Get_y_dx(time), mmotion_x->Get_y_dxdx(time));
+	set_row(rows[CHANNEL_EARTHQUAKE_Y], time, mmotion_y->Get_y(time), mmotion_y->Get_y_dx(time), mmotion_y->Get_y_dxdx(time));
+	for (int k = 0; k < NCOMPONENTS; ++k)
+		if (motion_components[k])
+			set_row(rows[CHANNEL_EARTHQUAKE_T + k], time, motion_components[k]->Get_y(time), motion_components[k]->Get_y_dx(time), motion_components[k]->Get_y_dxdx(time));
+
+	ChVector<> table_pos = plot_table->GetPos();
+	table_pos.x -= 4.05;	// because created at x=4.05, and we want to plot from 0
+	table_pos.y += 0.5;
+	set_row(rows[CHANNEL_TABLE], time, table_pos, plot_table->GetPos_dt(), plot_table->GetPos_dtdt());
+
+	set_row(rows[CHANNEL_BRICK_1], time, rel_disp_1,
+			ChVector<>(kinematics.vel_x[BRICK_1], kinematics.vel_y[BRICK_1], kinematics.vel_z[BRICK_1]),
+			ChVector<>(kinematics.acc_x[BRICK_1], kinematics.acc_y[BRICK_1], kinematics.acc_z[BRICK_1]));
+	set_row(rows[CHANNEL_BRICK_2], time, rel_disp_2,
+			ChVector<>(kinematics.vel_x[BRICK_2], kinematics.vel_y[BRICK_2], kinematics.vel_z[BRICK_2]),
+			ChVector<>(kinematics.acc_x[BRICK_2], kinematics.acc_y[BRICK_2], kinematics.acc_z[BRICK_2]));
+
+	// t  interface  body_a  body_b  n_contacts  N  T  penetration  slip_rate,
+	// one line per interface in contact (bodies numbered in creation order)
+	contacts.Update();
+	std::vector<double>& interfaces = rows[CHANNEL_INTERFACES];
+	interfaces.clear();
+	const std::vector<int>& active = contacts.GetActive();
+	for (size_t k = 0; k < active.size(); ++k)
+	{
+		int i = active[k];
+		double line[INTERFACE_FIELDS] = { time, (double)i, (double)contacts.body_a[i], (double)contacts.body_b[i], (double)contacts.n_contacts[i],
+										  contacts.normal_force[i], contacts.friction_force[i], contacts.penetration[i], contacts.slip_rate[i] };
+		interfaces.insert(interfaces.end(), line, line + INTERFACE_FIELDS);
+	}
+
+	if (base_step)
+	{
+		write_row(*data_earthquake_x, rows[CHANNEL_EARTHQUAKE_X], EARTHQUAKE_FIELDS);
+		write_row(*data_earthquake_y, rows[CHANNEL_EARTHQUAKE_Y], EARTHQUAKE_FIELDS);
+		for (int k = 0; k < NCOMPONENTS; ++k)
+			if (data_earthquake_components[k])
+				write_row(*data_earthquake_components[k], rows[CHANNEL_EARTHQUAKE_T + k], EARTHQUAKE_FIELDS);
+		write_row(*data_table,        rows[CHANNEL_TABLE],        BODY_FIELDS);
+		write_row(*data_brick_1,      rows[CHANNEL_BRICK_1],      BODY_FIELDS);
+		write_row(*data_brick_2,      rows[CHANNEL_BRICK_2],      BODY_FIELDS);
+		write_row(*data_interfaces,   rows[CHANNEL_INTERFACES],   INTERFACE_FIELDS);
+	}
+
+	if (capture)
+	{
+		double value = 0;
+		const char* trigger = Trigger(value);
+		capture->Push(time, rows, trigger, value);
+	}
+}
+
+const char* RunMonitor::Trigger(double& value)
+{
+	const CaptureSettings& settings = mcase.capture;
+	const char* trigger = 0;
+	value = 0;
+
+	// impacts: change of the normal impulse of an interface in one step
+	// (an interface that was not in contact had none)
+	if (settings.contact_impulse > 0)
+	{
+		interface_impulse.resize(contacts.GetNinterfaces(), 0.0);
+		interface_step.resize(contacts.GetNinterfaces(), -1);
+		const std::vector<int>& active = contacts.GetActive();
+		for (size_t k = 0; k < active.size(); ++k)
+		{
+			int i = active[k];
+			double previous = (interface_step[i] == step_count - 1) ? interface_impulse[i] : 0.0;
+			interface_impulse[i] = contacts.normal_force[i] * mcase.timestep;
+			interface_step[i] = step_count;
+			double jump = fabs(interface_impulse[i] - previous);
+			if (jump > settings.contact_impulse && jump > value)
+			{
+				trigger = "contact_impulse";
+				value = jump;
+			}
+		}
+		for (size_t k = 0; k < interfaces_previous.size(); ++k)
+		{
+			int i = interfaces_previous[k];
+			double jump = interface_impulse[i];		// contact lost
+			if (interface_step[i] != step_count && jump > settings.contact_impulse && jump > value)
+			{
+				trigger = "contact_impulse";
+				value = jump;
+			}
+		}
+		interfaces_previous.assign(active.begin(), active.end());
+	}
+
+	if (settings.rel_acc > 0 && !trigger)
+	{
+		double acc = std::max(kinematics.GetPos_dtdt(BRICK_1).Length(), kinematics.GetPos_dtdt(BRICK_2).Length());
+		if (acc > settings.rel_acc)
+		{
+			trigger = "rel_acc";
+			value = acc;
+		}
+	}
+
+	if (settings.tilt_rate > 0 && !trigger)
+	{
+		for (unsigned int idrum = 0; idrum < model->drums.size(); ++idrum)
+		{
+			double rate = fabs(drum_tilt[idrum] - drum_tilt_previous[idrum]) / mcase.timestep;
+			if (rate > settings.tilt_rate && rate > value)
+			{
+				trigger = "tilt_rate";
+				value = rate;
+			}
+		}
+	}
+
+	// at the first step the rates have no previous step
+	if (step_count <= 1)
+		return 0;
+	return trigger;
+}
+
+void RunMonitor::Finish()
+{
+	// Post-processing: response spectra of the input, and transfer functions
+	// from table to bricks, computed from the in-memory channels.
+	{
+		std::vector<const ResponseSpectrum*> spectra;
+		spectra.push_back(&spectrum_x);
+		spectra.push_back(&spectrum_y);
+		std::ofstream spectra_file(OutputFilename("spectra.dat").c_str());
+		spectra_file << "# T  PSA_x  PSA_y  (damping " << mcase.spectra_damping << ")\n";
+		write_spectra(spectra_file, spectra);
+
+		TransferFunction tf_brick_1_h, tf_brick_2_h, tf_brick_1_v, tf_brick_2_v;
+		tf_brick_1_h.Compute(acc_table_h, acc_brick_1_h, mcase.timestep);
+		tf_brick_2_h.Compute(acc_table_h, acc_brick_2_h, mcase.timestep);
+		tf_brick_1_v.Compute(acc_table_v, acc_brick_1_v, mcase.timestep);
+		tf_brick_2_v.Compute(acc_table_v, acc_brick_2_v, mcase.timestep);
+		std::vector<const TransferFunction*> tfs;
+		tfs.push_back(&tf_brick_1_h);
+		tfs.push_back(&tf_brick_2_h);
+		tfs.push_back(&tf_brick_1_v);
+		tfs.push_back(&tf_brick_2_v);
+		std::ofstream transfer_file(OutputFilename("transfer.dat").c_str());
+		transfer_file << "# f  (|H| phase coherence) for brick_1 h, brick_2 h, brick_1 v, brick_2 v\n";
+		write_transfer_functions(transfer_file, tfs);
+
+		std::ofstream tilts_file(OutputFilename("drum_tilts.dat").c_str());
+		metrics.WriteDrumTilts(tilts_file);
+	}
+
+	// Append the one-line summary of this run to summary.dat (with a
+	// header line, if the file is new) so that sweeps accumulate in one table.
+	{
+		std::string summary_filename = join_path(mcase.output_dir, "summary.dat");
+		bool summary_exists = std::ifstream(summary_filename.c_str()).good();
+		std::ofstream summary(summary_filename.c_str(), std::ios::app);
+		if (!summary_exists)
+			metrics.WriteHeader(summary);
+		char case_label[300];
+		sprintf(case_label, "%s_ampl%g", motion_name(mcase).c_str(), mcase.ampl_factor);
+		metrics.WriteRecord(summary, mcase.label.empty() ? std::string(case_label) : mcase.label);
+	}
+}
+
+
+
+// Iterations of the speed solver in the last step, for the telemetry
+
+static int solver_iterations(ChSystem& mphysicalSystem)
+{
+	ChLcpIterativeSolver* msolver = dynamic_cast<ChLcpIterativeSolver*>(mphysicalSystem.GetLcpSolverSpeed());
+	return msolver ? msolver->GetTotalIterations() : 0;
+}
+
+static void publish_step(WorkerStatus* status, ChSystem& mphysicalSystem)
+{
+	if (status)
+		status->Step(mphysicalSystem.GetChTime(), mphysicalSystem.GetNcontacts(), solver_iterations(mphysicalSystem));
+}
+
+bool run_case(const RunCase& mcase, const RecordLibrary& library, WorkerStatus* status)
+{
+	GetLog() << "Running case " << mcase.label.c_str() << "\n";
+
+	if (status)
+		status->BeginCase(mcase.label, mcase.t_end);
+
+	MemoryAccount memory(mcase.label);	// outlives the system
+	ChSystem mphysicalSystem;
+	TempleModel model;
+	if (!setup_case(mphysicalSystem, model, mcase, library, &memory))
+	{
+		if (status)
+			status->EndCase();
+		return false;
+	}
+
+	RunMonitor monitor(mphysicalSystem, model, mcase);
+
+	{
+		MemoryScope scope(&memory, MEMORY_SIMULATION);
+		while (mphysicalSystem.GetChTime() <= mcase.t_end)
+		{
+			mphysicalSystem.DoStepDynamics(mcase.timestep);
+			monitor.Update();
+			publish_step(status, mphysicalSystem);
+		}
+	}
+
+	monitor.Finish();
+	report_memory(memory, mphysicalSystem, mcase);
+	if (status)
+		status->EndCase();
+	return true;
+}
+
+
+
+// Rendezvous point for threads that advance in lockstep: each
+// Wait() returns only when all the n threads have called it.
+
+class StepBarrier
+{
+public:
+	StepBarrier(int n) : count(n), waiting(0), generation(0) {}
+
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		unsigned int gen = generation;
+		if (++waiting == count)
+		{
+			waiting = 0;
+			++generation;
+			cond.notify_all();
+		}
+		else
+			cond.wait(lock, [&]{ return gen != generation; });
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable cond;
+	int count;
+	int waiting;
+	unsigned int generation;
+};
+
+
+static void write_vector(ChStreamOutAsciiFile& out, const ChVector<>& v)
+{
+	out << " " << v.x << " " << v.y << " " << v.z;
+}
+
+bool run_comparison(const RunCase& case_a, const RunCase& case_b, const RecordLibrary& library, WorkerStatus* status)
+{
+	GetLog() << "Running case " << case_a.label.c_str() << " vs. " << case_b.label.c_str() << "\n";
+
+	// the rows pair the steps of the two cases
+	if (case_a.timestep != case_b.timestep)
+	{
+		GetLog() << "Cannot compare " << case_a.label.c_str() << " and " << case_b.label.c_str() << ": different timesteps \n";
+		return false;
+	}
+
+	if (status)
+		status->BeginCase(case_a.label + "_vs_" + case_b.label, case_a.t_end);
+
+	MemoryAccount memory_a(case_a.label);
+	MemoryAccount memory_b(case_b.label);
+	ChSystem system_a;
+	ChSystem system_b;
+	TempleModel model_a;
+	TempleModel model_b;
+
+	// Both models are built here, one after the other: the log and the
+	// identifiers of the Chrono objects are shared and not thread safe.
+	// Only the stepping runs in parallel, model B on the worker thread.
+	bool ok_a = setup_case(system_a, model_a, case_a, library, &memory_a);
+	bool ok_b = ok_a && setup_case(system_b, model_b, case_b, library, &memory_b);
+	if (!ok_a || !ok_b)
+	{
+		if (status)
+			status->EndCase();
+		return false;
+	}
+
+	RunMonitor monitor_a(system_a, model_a, case_a);
+	RunMonitor monitor_b(system_b, model_b, case_b);
+
+	std::string paired_name = join_path(case_a.output_dir, case_a.label + "_vs_" + case_b.label + ".dat");
+	ChStreamOutAsciiFile data_paired(paired_name.c_str());
+
+	StepBarrier barrier(2);
+	std::atomic<bool> done(false);
+	std::thread worker([&]()
+	{
+		MemoryScope scope(&memory_b, MEMORY_SIMULATION);
+		while (true)
+		{
+			barrier.Wait();		// step begins
+			if (done)
+				break;
+			system_b.DoStepDynamics(case_b.timestep);
+			monitor_b.Update();
+			barrier.Wait();		// step ends
+		}
+	});
+
+	MemoryScope scope(&memory_a, MEMORY_SIMULATION);
+	while (system_a.GetChTime() <= case_a.t_end)
+	{
+		barrier.Wait();
+		system_a.DoStepDynamics(case_a.timestep);
+		monitor_a.Update();
+		publish_step(status, system_a);
+		barrier.Wait();
+
+		// Both systems are at the same time: write the paired response,
+		// as  t  brick_1 (a, b, a-b)  brick_2 (a, b, a-b)
+		double time = system_a.GetChTime();
+		if (time >= case_a.t_save)
+		{
+			data_paired << time;
+			write_vector(data_paired, monitor_a.GetBrick1Displacement());
+			write_vector(data_paired, monitor_b.GetBrick1Displacement());
+			write_vector(data_paired, monitor_a.GetBrick1Displacement() - monitor_b.GetBrick1Displacement());
+			write_vector(data_paired, monitor_a.GetBrick2Displacement());
+			write_vector(data_paired, monitor_b.GetBrick2Displacement());
+			write_vector(data_paired, monitor_a.GetBrick2Displacement() - monitor_b.GetBrick2Displacement());
+			data_paired << "\n";
+		}
+	}
+	done = true;
+	barrier.Wait();
+	worker.join();
+
+	monitor_a.Finish();
+	monitor_b.Finish();
+	report_memory(memory_a, system_a, case_a);
+	report_memory(memory_b, system_b, case_b);
+	if (status)
+		status->EndCase();
+	return true;
+}
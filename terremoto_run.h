@@ -0,0 +1,204 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_RUN_H
+#define TERREMOTO_RUN_H
+
+///////////////////////////////////////////////////
+//
+//   Simulation cases: settings of one run, the
+//   per-step monitoring of its response, and the
+//   runner used for sweeps without visualization.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "core/ChStream.h"
+
+#include "terremoto_model.h"
+#include "terremoto_metrics.h"
+#include "terremoto_spectra.h"
+#include "terremoto_records.h"
+#include "terremoto_motion.h"
+#include "terremoto_kinematics.h"
+#include "terremoto_contacts.h"
+#include "terremoto_telemetry.h"
+#include "terremoto_memory.h"
+#include "terremoto_capture.h"
+
+
+/// Settings of one simulation case.
+
+class RunCase
+{
+public:
+	RunCase();
+
+	std::string label;			// names the output files and the summary record
+	std::string output_dir;		// directory of the output files, "" for the current one
+	std::string record_set;		// set of the records in the library, "" for any
+	std::string record_h;		// name of the horizontal record in the library
+	std::string record_v;		// name of the vertical record, "" for none
+	std::string record_multi;	// combined record  t x y z [rx ry rz]  (see MultiComponentMotion), used instead of the records and streams if not ""
+	std::string stream_h;		// pipe or FIFO streaming the horizontal motion, used instead of record_h if not ""
+	std::string stream_v;		// pipe or FIFO streaming the vertical motion, used instead of record_v if not ""
+	int    stream_window;		// samples kept in memory for each stream
+	double ampl_factor;			// use lower or greater to scale the earthquake.
+	double time_offset;			// begin earthquake after this to allow stabilization of blocks after creation.
+	double t_save;				// save only after this to avoid plotting initial settlement
+	double t_end;				// exit simulation if time greater than this
+	double timestep;
+	bool   simple_temple;
+	MaterialParams material;	// of the drums
+	std::vector<MaterialPair> material_pairs;	// contact parameters of some pairs of materials; if any, the model uses a material table
+	MotionPreprocessing preprocessing;	// of the records, before imposing them to the table
+	bool   save_full_dumps;		// if false, only the one-line summary of the run is saved, in summary.dat
+	CaptureSettings capture;	// base rate of the full dumps, and full-rate capture around events
+	bool   deterministic;		// single-threaded run, with identical output across runs
+
+	// period grid and damping of the response spectra of the input
+	double spectra_T_min;
+	double spectra_T_max;
+	int    spectra_n_periods;
+	double spectra_damping;
+};
+
+
+/// Set up a case in an empty system: create the temple model, and
+/// impose the case records (from the library) to the table.
+/// Returns false if the records are not in the library. Streamed
+/// motions are used raw, without preprocessing.
+/// If an account is given, the bodies and the motions are built in its
+/// arena, and charged to it.
+
+bool setup_case(chrono::ChSystem& mphysicalSystem,
+				TempleModel& model,
+				const RunCase& mcase,
+				const RecordLibrary& library,
+				MemoryAccount* memory = 0);
+
+/// Log the memory of a case, per body and per contact, and append
+/// its record to memory.dat in the output directory of the case.
+
+void report_memory(const MemoryAccount& memory, chrono::ChSystem& mphysicalSystem, const RunCase& mcase);
+
+
+/// Monitoring of the response of a model along a run: it updates the
+/// streaming metrics and spectra, keeps the channels for the transfer
+/// functions, and optionally writes the full time histories, including
+/// the contact resultants at each body interface, at the base rate of
+/// the case, with full-rate captures around the trigger events.
+/// Call Update() after each time step, and Finish() at the end.
+
+class RunMonitor
+{
+public:
+	RunMonitor(chrono::ChSystem& mphysicalSystem, TempleModel& model, const RunCase& mcase);
+	~RunMonitor();
+
+	void Update();
+
+		/// Displacements of the plotted bricks relative to the table (net of
+		/// the initial settlement) at the last Update().
+	const chrono::ChVector<>& GetBrick1Displacement() const { return rel_disp_1; }
+	const chrono::ChVector<>& GetBrick2Displacement() const { return rel_disp_2; }
+
+		/// Tilt angles of the drums relative to the table at the last Update(),
+		/// in the order of TempleModel::drums.
+	const std::vector<double>& GetDrumTilts() const { return drum_tilt; }
+
+		/// Write spectra, transfer functions and peak drum tilts, and append the summary
+		/// record of the run to summary.dat.
+	void Finish();
+
+	ResponseMetrics  metrics;
+	ResponseSpectrum spectrum_x;
+	ResponseSpectrum spectrum_y;
+
+private:
+	std::string OutputFilename(const char* name) const;
+
+	// indexes of the bodies in the kinematics buffers
+	enum { BRICK_1 = 0, BRICK_2 = 1, FIRST_DRUM = 2 };
+
+	// channels of the full dumps, and their fields per line
+	enum { CHANNEL_EARTHQUAKE_X = 0, CHANNEL_EARTHQUAKE_Y,
+		   CHANNEL_EARTHQUAKE_T, CHANNEL_EARTHQUAKE_RX, CHANNEL_EARTHQUAKE_RY, CHANNEL_EARTHQUAKE_RZ,
+		   CHANNEL_TABLE, CHANNEL_BRICK_1, CHANNEL_BRICK_2, CHANNEL_INTERFACES, NCHANNELS };
+	enum { NCOMPONENTS = 4 };	// channels of the other components of a combined record, from CHANNEL_EARTHQUAKE_T
+	enum { EARTHQUAKE_FIELDS = 4, BODY_FIELDS = 10, INTERFACE_FIELDS = 9 };
+
+		// The trigger that fires at this step, if any (and its value)
+	const char* Trigger(double& value);
+
+	chrono::ChSystem* msystem;
+	TempleModel* model;
+	RunCase mcase;
+
+	RelativeKinematics kinematics;	// bricks and drums, relative to the table
+	ContactInterfaces  contacts;	// forces and sliding at the body interfaces
+
+	chrono::ChVector<> brick_1_initial_displacement;
+	chrono::ChVector<> brick_2_initial_displacement;
+	chrono::ChVector<> rel_disp_1;
+	chrono::ChVector<> rel_disp_2;
+
+	// Absolute accelerations of table and bricks, kept in memory for the transfer
+	// functions (horizontal = Z, the direction of SetMotion_Z, and vertical = Y)
+	std::vector<double> acc_table_h, acc_table_v;
+	std::vector<double> acc_brick_1_h, acc_brick_1_v;
+	std::vector<double> acc_brick_2_h, acc_brick_2_v;
+
+	// Files for output data, only if full dumps are enabled
+	chrono::ChStreamOutAsciiFile* data_earthquake_x;
+	chrono::ChStreamOutAsciiFile* data_earthquake_y;
+	chrono::ChStreamOutAsciiFile* data_table;
+	chrono::ChStreamOutAsciiFile* data_brick_1;
+	chrono::ChStreamOutAsciiFile* data_brick_2;
+	chrono::ChStreamOutAsciiFile* data_interfaces;
+
+	// Other components of a combined record: X translation of the link
+	// (transverse) and rotations, with their files; 0 if not imposed
+	chrono::ChFunction* motion_components[NCOMPONENTS];
+	chrono::ChStreamOutAsciiFile* data_earthquake_components[NCOMPONENTS];
+
+	// Rows of the last step, and the state of the triggers
+	std::vector<double> rows[NCHANNELS];
+	std::vector<double> drum_tilt, drum_tilt_previous;
+	std::vector<double> interface_impulse;	// normal impulse of each interface at its last step in contact
+	std::vector<long> interface_step;		// and that step
+	std::vector<int> interfaces_previous;	// interfaces in contact at the previous step
+	long step_count;
+	EventCapture* capture;		// only if full dumps and some trigger are enabled
+};
+
+
+/// Run a case to its end without visualization. If a worker status is
+/// given, the progress is published there after each step.
+/// Returns false if the case could not be set up.
+
+bool run_case(const RunCase& mcase, const RecordLibrary& library, WorkerStatus* status = 0);
+
+
+/// Run two cases that differ only by their records (ex. a barrier and a
+/// no-barrier variant) side by side: the two models live in two ChSystem
+/// instances, built and stepped on two threads in lockstep, sharing the
+/// record library. Besides the output of each case, the paired response
+/// and its difference (case_a - case_b) are written to <label_a>_vs_<label_b>.dat
+/// The progress of case_a is published in the worker status, if given.
+/// Returns false if one of the cases could not be set up.
+
+bool run_comparison(const RunCase& case_a, const RunCase& case_b, const RecordLibrary& library, WorkerStatus* status = 0);
+
+
+#endif
@@ -0,0 +1,239 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cmath>
+#include <algorithm>
+
+#include "core/ChMath.h"
+
+#include "terremoto_spectra.h"
+
+using namespace chrono;
+
+
+ResponseSpectrum::ResponseSpectrum(double mdt, double T_min, double T_max, int n_periods, double mdamping)
+	: dt(mdt), damping(mdamping)
+{
+	periods.resize(n_periods);
+	for (int i = 0; i < n_periods; ++i)
+	{
+		double s = (n_periods > 1) ? (double)i / (double)(n_periods - 1) : 0.0;
+		periods[i] = T_min * pow(T_max / T_min, s);
+	}
+	Setup();
+}
+
+ResponseSpectrum::ResponseSpectrum(double mdt, const std::vector<double>& mperiods, double mdamping)
+	: dt(mdt), damping(mdamping), periods(mperiods)
+{
+	Setup();
+}
+
+void ResponseSpectrum::Setup()
+{
+	size_t n = periods.size();
+	omega2.resize(n);
+	A.resize(n); B.resize(n); C.resize(n); D.resize(n);
+	Ad.resize(n); Bd.resize(n); Cd.resize(n); Dd.resize(n);
+
+	// Recurrence formulas for piecewise-linear excitation, unit mass,
+	// see Chopra, "Dynamics of Structures", table 5.2.1.
+	double xi  = damping;
+	double sq  = sqrt(1.0 - xi*xi);
+	for (size_t i = 0; i < n; ++i)
+	{
+		double w   = CH_C_2PI / periods[i];
+		double wd  = w * sq;
+		double k   = w * w;
+		double e   = exp(-xi * w * dt);
+		double s   = sin(wd * dt);
+		double c   = cos(wd * dt);
+		double r   = xi / sq;
+		double wdt = w * dt;
+
+		omega2[i] = k;
+		A[i]  = e * (r*s + c);
+		B[i]  = e * (s / wd);
+		C[i]  = (1.0/k) * (2*xi/wdt + e*(((1 - 2*xi*xi)/(wd*dt) - r)*s - (1 + 2*xi/wdt)*c));
+		D[i]  = (1.0/k) * (1 - 2*xi/wdt + e*(((2*xi*xi - 1)/(wd*dt))*s + (2*xi/wdt)*c));
+		Ad[i] = -e * (w / sq) * s;
+		Bd[i] = e * (c - r*s);
+		Cd[i] = (1.0/k) * (-1.0/dt + e*((w/sq + r/dt)*s + c/dt));
+		Dd[i] = (1.0/(k*dt)) * (1 - e*(r*s + c));
+	}
+	Reset();
+}
+
+void ResponseSpectrum::Reset()
+{
+	size_t n = periods.size();
+	u.assign(n, 0.0);
+	v.assign(n, 0.0);
+	peak_u.assign(n, 0.0);
+	last_p = 0;
+}
+
+void ResponseSpectrum::Update(double ground_acc)
+{
+	// load per unit mass
+	double p = -ground_acc;
+
+	int n = (int)periods.size();
+	double* mu  = &u[0];
+	double* mv  = &v[0];
+	double* mpk = &peak_u[0];
+	for (int i = 0; i < n; ++i)
+	{
+		double un = A[i] *mu[i] + B[i] *mv[i] + C[i] *last_p + D[i] *p;
+		double vn = Ad[i]*mu[i] + Bd[i]*mv[i] + Cd[i]*last_p + Dd[i]*p;
+		mu[i] = un;
+		mv[i] = vn;
+		mpk[i] = std::max(mpk[i], fabs(un));
+	}
+	last_p = p;
+}
+
+
+
+void fft_radix2(std::vector< std::complex<double> >& data, bool inverse)
+{
+	size_t n = data.size();
+	if (n < 2)
+		return;
+
+	// bit-reversal permutation
+	for (size_t i = 1, j = 0; i < n; ++i)
+	{
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(data[i], data[j]);
+	}
+
+	// butterflies
+	for (size_t len = 2; len <= n; len <<= 1)
+	{
+		double ang = (inverse ? CH_C_2PI : -CH_C_2PI) / (double)len;
+		std::complex<double> wlen(cos(ang), sin(ang));
+		for (size_t i = 0; i < n; i += len)
+		{
+			std::complex<double> w(1.0, 0.0);
+			for (size_t j = 0; j < len/2; ++j)
+			{
+				std::complex<double> a = data[i + j];
+				std::complex<double> b = data[i + j + len/2] * w;
+				data[i + j]         = a + b;
+				data[i + j + len/2] = a - b;
+				w *= wlen;
+			}
+		}
+	}
+
+	if (inverse)
+		for (size_t i = 0; i < n; ++i)
+			data[i] /= (double)n;
+}
+
+
+
+void TransferFunction::Compute(const std::vector<double>& input,
+							   const std::vector<double>& output,
+							   double dt,
+							   int n_smooth)
+{
+	frequency.clear();
+	amplitude.clear();
+	phase.clear();
+	coherence.clear();
+
+	size_t nsamples = std::min(input.size(), output.size());
+	if (nsamples < 2)
+		return;
+
+	size_t n = 1;
+	while (n < nsamples)
+		n <<= 1;
+
+	std::vector< std::complex<double> > X(n, 0.0);
+	std::vector< std::complex<double> > Y(n, 0.0);
+	for (size_t i = 0; i < nsamples; ++i)
+	{
+		X[i] = input[i];
+		Y[i] = output[i];
+	}
+	fft_radix2(X);
+	fft_radix2(Y);
+
+	// one-sided raw spectra
+	size_t nf = n/2 + 1;
+	std::vector<double> Sxx(nf), Syy(nf);
+	std::vector< std::complex<double> > Sxy(nf);
+	for (size_t k = 0; k < nf; ++k)
+	{
+		Sxx[k] = std::norm(X[k]);
+		Syy[k] = std::norm(Y[k]);
+		Sxy[k] = std::conj(X[k]) * Y[k];
+	}
+
+	frequency.resize(nf);
+	amplitude.resize(nf);
+	phase.resize(nf);
+	coherence.resize(nf);
+	for (size_t k = 0; k < nf; ++k)
+	{
+		size_t k0 = (k > (size_t)n_smooth) ? k - n_smooth : 0;
+		size_t k1 = std::min(nf - 1, k + n_smooth);
+		double sxx = 0, syy = 0;
+		std::complex<double> sxy(0, 0);
+		for (size_t j = k0; j <= k1; ++j)
+		{
+			sxx += Sxx[j];
+			syy += Syy[j];
+			sxy += Sxy[j];
+		}
+		std::complex<double> H = (sxx > 0) ? sxy / sxx : std::complex<double>(0, 0);
+
+		frequency[k] = (double)k / (n * dt);
+		amplitude[k] = std::abs(H);
+		phase[k]     = std::arg(H);
+		coherence[k] = (sxx > 0 && syy > 0) ? std::norm(sxy) / (sxx * syy) : 0.0;
+	}
+}
+
+
+
+void write_spectra(std::ostream& out, const std::vector<const ResponseSpectrum*>& spectra)
+{
+	if (spectra.empty())
+		return;
+	for (int i = 0; i < spectra[0]->GetNperiods(); ++i)
+	{
+		out << spectra[0]->GetPeriod(i);
+		for (size_t j = 0; j < spectra.size(); ++j)
+			out << " " << spectra[j]->GetPSA(i);
+		out << "\n";
+	}
+}
+
+void write_transfer_functions(std::ostream& out, const std::vector<const TransferFunction*>& tfs)
+{
+	if (tfs.empty())
+		return;
+	for (size_t k = 0; k < tfs[0]->frequency.size(); ++k)
+	{
+		out << tfs[0]->frequency[k];
+		for (size_t j = 0; j < tfs.size(); ++j)
+			out << " " << tfs[j]->amplitude[k] << " " << tfs[j]->phase[k] << " " << tfs[j]->coherence[k];
+		out << "\n";
+	}
+}
@@ -0,0 +1,116 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_SPECTRA_H
+#define TERREMOTO_SPECTRA_H
+
+///////////////////////////////////////////////////
+//
+//   Post-processing of input and response signals
+//   at the end of a run:
+//
+//     - elastic pseudo-acceleration response spectra,
+//       updated step by step while the simulation runs
+//     - FFT-based transfer functions between channels
+//
+///////////////////////////////////////////////////
+
+#include <vector>
+#include <complex>
+#include <ostream>
+
+
+/// Pseudo-acceleration response spectrum of a ground acceleration,
+/// computed in streaming mode: one Update() per time step advances
+/// a whole bank of damped SDOF oscillators (one per period of the grid),
+/// using the exact recurrence for piecewise-linear excitation
+/// (Nigam & Jennings). Because the time step is fixed, the recurrence
+/// coefficients are computed once, and each step is a sweep over
+/// contiguous arrays that the compiler can vectorize.
+
+class ResponseSpectrum
+{
+public:
+		/// Set up n_periods oscillators with periods log-spaced in [T_min, T_max],
+		/// with damping ratio 'damping', for a signal sampled at fixed step 'dt'.
+	ResponseSpectrum(double dt, double T_min = 0.02, double T_max = 5.0, int n_periods = 100, double damping = 0.05);
+
+		/// As above, but with an arbitrary grid of periods.
+	ResponseSpectrum(double dt, const std::vector<double>& periods, double damping = 0.05);
+
+		/// Restart from oscillators at rest.
+	void Reset();
+
+		/// Advance all oscillators by one step, given the ground acceleration
+		/// at the end of the step.
+	void Update(double ground_acc);
+
+	int GetNperiods() const { return (int)periods.size(); }
+	double GetPeriod(int i) const { return periods[i]; }
+
+		/// Pseudo-spectral acceleration  PSA = w^2 * max|u|  at period i.
+	double GetPSA(int i) const { return omega2[i] * peak_u[i]; }
+
+		/// Spectral displacement  max|u|  at period i.
+	double GetSD(int i) const { return peak_u[i]; }
+
+private:
+	void Setup();
+
+	double dt;
+	double damping;
+	double last_p;
+	std::vector<double> periods;
+	std::vector<double> omega2;
+	// recurrence coefficients, per period
+	std::vector<double> A, B, C, D, Ad, Bd, Cd, Dd;
+	// oscillator state, per period
+	std::vector<double> u, v, peak_u;
+};
+
+
+/// In-place radix-2 FFT. The size of the data must be a power of two.
+
+void fft_radix2(std::vector< std::complex<double> >& data, bool inverse = false);
+
+
+/// Transfer function  H(f) = S_xy(f) / S_xx(f)  between an input and
+/// an output channel, both sampled at fixed step dt. The signals are
+/// zero-padded to a power of two; auto- and cross-spectra are smoothed
+/// over 2*n_smooth+1 neighbouring bins before the division.
+
+class TransferFunction
+{
+public:
+	void Compute(const std::vector<double>& input,
+				 const std::vector<double>& output,
+				 double dt,
+				 int n_smooth = 2);
+
+	std::vector<double> frequency;	// Hz
+	std::vector<double> amplitude;	// |H|
+	std::vector<double> phase;		// rad
+	std::vector<double> coherence;	// in [0,1]
+};
+
+
+/// Write a set of spectra sharing the same period grid, one row per period:
+/// T  PSA_0  PSA_1 ...
+
+void write_spectra(std::ostream& out, const std::vector<const ResponseSpectrum*>& spectra);
+
+/// Write a set of transfer functions sharing the same frequency grid, one
+/// row per frequency:  f  |H_0|  phase_0  coh_0  |H_1| ...
+
+void write_transfer_functions(std::ostream& out, const std::vector<const TransferFunction*>& tfs);
+
+
+#endif
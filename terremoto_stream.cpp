@@ -0,0 +1,358 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "core/ChLog.h"
+
+#include "terremoto_stream.h"
+
+using namespace chrono;
+
+
+// The lines of the source of a stream. On POSIX systems the source is
+// opened without blocking and polled, so that the producer can give up
+// when asked to stop, even on a FIFO that has no writer yet.
+
+class StreamLineReader
+{
+public:
+	StreamLineReader(const std::string& source, const std::atomic<bool>& mstop) : stop(mstop), start(0)
+	{
+#ifdef _WIN32
+		f = (source == "-") ? stdin : fopen(source.c_str(), "r");
+#else
+		fd = (source == "-") ? 0 : open(source.c_str(), O_RDONLY | O_NONBLOCK);
+#endif
+	}
+
+	~StreamLineReader()
+	{
+#ifdef _WIN32
+		if (f && f != stdin)
+			fclose(f);
+#else
+		if (fd > 0)
+			close(fd);
+#endif
+	}
+
+#ifdef _WIN32
+	bool IsOpen() const { return f != 0; }
+#else
+	bool IsOpen() const { return fd >= 0; }
+#endif
+
+		// Next line, with its newline if any; false at the end of the source,
+		// or once stop is set.
+	bool Next(std::string& line);
+
+private:
+	const std::atomic<bool>& stop;
+#ifdef _WIN32
+	FILE* f;
+#else
+	int fd;
+#endif
+	std::string buffer;		// read, from 'start' on not returned yet
+	size_t start;
+};
+
+bool StreamLineReader::Next(std::string& line)
+{
+#ifdef _WIN32
+	char text[256];
+	if (stop || !f || !fgets(text, sizeof(text), f))
+		return false;
+	line = text;
+	return true;
+#else
+	while (!stop && fd >= 0)
+	{
+		size_t newline = buffer.find('\n', start);
+		if (newline != std::string::npos)
+		{
+			line.assign(buffer, start, newline + 1 - start);
+			start = newline + 1;
+			return true;
+		}
+		buffer.erase(0, start);
+		start = 0;
+
+		// A FIFO without writer is not ready (nor at its end) until one
+		// opens it: wait in short polls, checking stop in between.
+		struct pollfd ready;
+		ready.fd = fd;
+		ready.events = POLLIN;
+		ready.revents = 0;
+		int nready = poll(&ready, 1, 100);
+		if (nready < 0 && errno != EINTR)
+			break;
+		if (nready <= 0)
+			continue;
+
+		char chunk[4096];
+		ssize_t n = read(fd, chunk, sizeof(chunk));
+		if (n < 0 && (errno == EAGAIN || errno == EINTR))
+			continue;
+		if (n <= 0)
+			break;		// end of the file, or the writer closed the FIFO
+		buffer.append(chunk, (size_t)n);
+	}
+
+	// the last line may have no newline
+	if (stop || start >= buffer.size())
+		return false;
+	line.assign(buffer, start, std::string::npos);
+	start = buffer.size();
+	return true;
+#endif
+}
+
+
+
+StreamingMotion::StreamingMotion(const std::string& msource, double mt_offset, double mfactor, size_t mwindow, size_t mhistory)
+	: source(msource),
+	  reader(0),
+	  t_offset(mt_offset),
+	  factor(mfactor),
+	  history(std::min(mhistory, std::max(mwindow, (size_t)8) / 2)),
+	  times(std::max(mwindow, (size_t)8)),
+	  values(std::max(mwindow, (size_t)8)),
+	  begin(0),
+	  end(0),
+	  cursor(0),
+	  finished(false),
+	  stop(false),
+	  last_y(0),
+	  wait_time(0)
+{
+	// Opened here, so that a missing source fails the case at once. The
+	// open does not block, also on a FIFO without writer yet.
+	reader = new StreamLineReader(source, stop);
+	if (!reader->IsOpen())
+		GetLog() << "Cannot open motion stream " << source.c_str() << "\n";
+	producer = std::thread(&StreamingMotion::Produce, this);
+}
+
+StreamingMotion::~StreamingMotion()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	cond_space.notify_all();
+	producer.join();
+	delete reader;
+}
+
+bool StreamingMotion::IsOpen() const
+{
+	return reader->IsOpen();
+}
+
+ChFunction* StreamingMotion::new_Duplicate()
+{
+	GetLog() << "Motion stream " << source.c_str() << " cannot be duplicated\n";
+	assert(false);
+	return 0;
+}
+
+
+
+void StreamingMotion::Produce()
+{
+	size_t nreceived = 0;
+	size_t ndropped = 0;
+	bool have_last = false;
+	double t_last = 0;
+	std::string line;
+	while (reader->Next(line))
+	{
+		const char* p = line.c_str();
+		while (*p == ' ' || *p == '\t')
+			++p;
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0)
+			continue;
+		char* e1;
+		char* e2;
+		double time = strtod(p, &e1);
+		double value = strtod(e1, &e2);
+		if (e1 == p || e2 == e1)
+			continue;
+		time += t_offset;
+		value *= factor;
+		if (have_last && time <= t_last)
+		{
+			++ndropped;
+			continue;
+		}
+		have_last = true;
+		t_last = time;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		cond_space.wait(lock, [this]{ return stop || end - begin < times.size(); });
+		if (stop)
+			break;
+		times[end % times.size()] = time;
+		values[end % values.size()] = value;
+		++end;
+		nreceived = end;
+		lock.unlock();
+		cond_samples.notify_all();
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished = true;
+	}
+	cond_samples.notify_all();
+
+	GetLog() << "Motion stream " << source.c_str() << " ended after " << (int)nreceived << " samples";
+	if (ndropped)
+		GetLog() << " (" << (int)ndropped << " out of order, dropped)";
+	GetLog() << "\n";
+}
+
+bool StreamingMotion::Window(double x, double t[4], double v[4])
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		if (end > begin)
+		{
+			// time advances by small steps: move the cursor from the last interval
+			cursor = std::min(std::max(cursor, begin), end - 1);
+			while (cursor + 1 < end && Time(cursor + 1) <= x)
+				++cursor;
+			while (cursor > begin && Time(cursor) > x)
+				--cursor;
+
+			// release the samples no longer needed to the producer
+			size_t new_begin = (cursor > history) ? cursor - history : 0;
+			if (new_begin > begin)
+			{
+				begin = new_begin;
+				cond_space.notify_all();
+			}
+		}
+
+		// the sample after the interval of x is needed too
+		if (finished || (end - begin >= 2 && Time(end - 2) > x))
+			break;
+
+		std::chrono::steady_clock::time_point wait_start = std::chrono::steady_clock::now();
+		cond_samples.wait(lock);
+		wait_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count();
+	}
+
+	if (end == begin)
+		return false;
+
+	size_t i[4];
+	if (x < Time(cursor))
+		i[0] = i[1] = i[2] = i[3] = cursor;		// before the first sample kept
+	else
+	{
+		i[0] = (cursor > begin) ? cursor - 1 : cursor;
+		i[1] = cursor;
+		i[2] = std::min(cursor + 1, end - 1);
+		i[3] = std::min(cursor + 2, end - 1);
+	}
+	for (int k = 0; k < 4; ++k)
+	{
+		t[k] = Time(i[k]);
+		v[k] = Value(i[k]);
+	}
+	return true;
+}
+
+
+// Cubic Hermite interpolation between samples 1 and 2, with the
+// Catmull-Rom tangents (finite differences over samples 0..2 and 1..3).
+
+static void interpolate(const double t[4], const double v[4], double x, double& y, double& y_dx, double& y_dxdx)
+{
+	double h = t[2] - t[1];
+	if (h <= 0)
+	{
+		y = v[1];
+		y_dx = y_dxdx = 0;
+		return;
+	}
+	double m1 = (t[2] > t[0]) ? (v[2] - v[0]) / (t[2] - t[0]) : 0;
+	double m2 = (t[3] > t[1]) ? (v[3] - v[1]) / (t[3] - t[1]) : 0;
+	double s = std::min(std::max((x - t[1]) / h, 0.0), 1.0);
+	double s2 = s * s;
+	double s3 = s2 * s;
+
+	y      =  (2*s3 - 3*s2 + 1) * v[1] + (s3 - 2*s2 + s) * h * m1 + (-2*s3 + 3*s2) * v[2] + (s3 - s2) * h * m2;
+	y_dx   = ((6*s2 - 6*s) * v[1] + (3*s2 - 4*s + 1) * h * m1 + (-6*s2 + 6*s) * v[2] + (3*s2 - 2*s) * h * m2) / h;
+	y_dxdx = ((12*s - 6) * v[1] + (6*s - 4) * h * m1 + (-12*s + 6) * v[2] + (6*s - 2) * h * m2) / (h * h);
+}
+
+double StreamingMotion::Get_y(double x)
+{
+	double t[4], v[4], y, y_dx, y_dxdx;
+	if (!Window(x, t, v))
+		return 0;
+	interpolate(t, v, x, y, y_dx, y_dxdx);
+	std::lock_guard<std::mutex> lock(mutex);
+	last_y = y;
+	return y;
+}
+
+double StreamingMotion::Get_y_dx(double x)
+{
+	double t[4], v[4], y, y_dx, y_dxdx;
+	if (!Window(x, t, v))
+		return 0;
+	interpolate(t, v, x, y, y_dx, y_dxdx);
+	return y_dx;
+}
+
+double StreamingMotion::Get_y_dxdx(double x)
+{
+	double t[4], v[4], y, y_dx, y_dxdx;
+	if (!Window(x, t, v))
+		return 0;
+	interpolate(t, v, x, y, y_dx, y_dxdx);
+	return y_dxdx;
+}
+
+void StreamingMotion::Estimate_x_range(double& xmin, double& xmax)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	xmin = (end > begin) ? Time(begin) : 0;
+	xmax = (end > begin) ? Time(end - 1) : 0;
+}
+
+size_t StreamingMotion::GetNreceived()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return end;
+}
+
+double StreamingMotion::GetWaitTime()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return wait_time;
+}
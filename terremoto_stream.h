@@ -0,0 +1,130 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_STREAM_H
+#define TERREMOTO_STREAM_H
+
+///////////////////////////////////////////////////
+//
+//   Ground motion streamed from a pipe or a FIFO,
+//   for records too long to be loaded at once, or
+//   produced while the simulation runs by a
+//   separate generator process.
+//
+//   The stream is read as two-column time/value
+//   text lines (displacements, as the record files;
+//   '#' lines are skipped) by a producer thread,
+//   into a window of fixed size that slides as the
+//   simulation time advances: the memory does not
+//   depend on the length of the record.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "motion_functions/ChFunction_Base.h"
+
+
+class StreamLineReader;
+
+
+/// Motion function that interpolates the samples of a stream with a
+/// Catmull-Rom cubic (continuous value and speed), needing only the
+/// four samples around the evaluated time.
+///
+/// An evaluation beyond the samples received waits for the producer;
+/// the producer waits when the window is full, i.e. when it is ahead
+/// of the simulation. Before the first sample and after the end of the
+/// stream the function is constant. Times must increase: samples
+/// that do not are dropped.
+
+class StreamingMotion : public chrono::ChFunction
+{
+public:
+		/// Open 'source' (a FIFO, a file, or "-" for the standard input)
+		/// and start reading it, shifting the times by t_offset and scaling the values by
+		/// factor. The window holds 'window' samples; 'history' of them, the
+		/// latest before the evaluated time, are kept for steps that
+		/// evaluate back in time.
+	StreamingMotion(const std::string& msource,
+					double mt_offset = 0,
+					double mfactor = 1.0,
+					size_t mwindow = 4096,
+					size_t mhistory = 64);
+
+		/// Stops the producer: it polls the source, so this returns also
+		/// when a FIFO has no writer, or the writer stalls (except on
+		/// Windows, where the reads block).
+	~StreamingMotion();
+
+		/// A stream cannot be read twice: not duplicable (asserts, and
+		/// returns 0), so do not impose it on a link that gets copied.
+	chrono::ChFunction* new_Duplicate();
+
+	double Get_y      (double x);
+	double Get_y_dx   (double x);
+	double Get_y_dxdx (double x);
+
+	void Estimate_x_range(double& xmin, double& xmax);
+
+		/// Number of samples received so far
+	size_t GetNreceived();
+
+		/// Wall time the simulation spent waiting for the producer, in seconds
+	double GetWaitTime();
+
+	const std::string& GetSource() const { return source; }
+
+		/// False if the source could not be opened: the function would be
+		/// zero, so the case should not run.
+	bool IsOpen() const;
+
+private:
+	void Produce();
+
+		// Wait until the samples around x are in the window (or the stream
+		// ended), and get the four samples p0..p3 whose interval p1..p2
+		// holds x. Returns false if there are no samples at all.
+	bool Window(double x, double t[4], double v[4]);
+
+	double Time(size_t k) const { return times[k % times.size()]; }
+	double Value(size_t k) const { return values[k % values.size()]; }
+
+	std::string source;
+	StreamLineReader* reader;	// opened by the constructor, read by the producer
+	double t_offset;
+	double factor;
+	size_t history;
+
+	// ring buffer: samples begin..end-1 are at index k % size
+	std::vector<double> times;
+	std::vector<double> values;
+	size_t begin;
+	size_t end;
+	size_t cursor;		// interval of the last evaluation
+	bool finished;		// no more samples will come
+	std::atomic<bool> stop;	// also polled by the producer while it waits for the source
+	double last_y;		// value at the last evaluation
+	double wait_time;
+
+	std::mutex mutex;
+	std::condition_variable cond_space;
+	std::condition_variable cond_samples;
+	std::thread producer;
+};
+
+
+#endif
@@ -0,0 +1,152 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#include <cstdio>
+#include <fstream>
+
+#include "terremoto_telemetry.h"
+
+
+void WorkerStatus::BeginCase(const std::string& mlabel, double mt_end)
+{
+	{
+		std::lock_guard<std::mutex> lock(label_mutex);
+		label = mlabel;
+	}
+	sim_time = 0;
+	t_end = mt_end;
+	contacts = 0;
+	solver_iterations = 0;
+	steps = 0;
+	active = true;
+}
+
+std::string WorkerStatus::GetLabel() const
+{
+	std::lock_guard<std::mutex> lock(label_mutex);
+	return label;
+}
+
+
+
+Telemetry::Telemetry(const std::string& mfilename, int nworkers, double mperiod, double mstall_timeout)
+	: filename(mfilename),
+	  period(mperiod),
+	  stall_timeout(mstall_timeout),
+	  started(clock::now()),
+	  samples(nworkers),
+	  cases_total(0),
+	  cases_done(0),
+	  cases_failed(0),
+	  stop(false)
+{
+	for (int i = 0; i < nworkers; ++i)
+		workers.push_back(new WorkerStatus);
+	writer = std::thread(&Telemetry::Run, this);
+}
+
+Telemetry::~Telemetry()
+{
+	{
+		std::lock_guard<std::mutex> lock(stop_mutex);
+		stop = true;
+	}
+	stop_cond.notify_all();
+	writer.join();
+	for (size_t i = 0; i < workers.size(); ++i)
+		delete workers[i];
+}
+
+void Telemetry::Run()
+{
+	std::unique_lock<std::mutex> lock(stop_mutex);
+	while (true)
+	{
+		bool stopping = stop_cond.wait_for(lock, std::chrono::duration<double>(period), [this]{ return stop; });
+		Write();
+		if (stopping)
+			break;
+	}
+}
+
+void Telemetry::Write()
+{
+	clock::time_point now = clock::now();
+	int total = cases_total;
+	int done = cases_done;
+	int running = 0;
+	for (size_t i = 0; i < workers.size(); ++i)
+		if (workers[i]->active)
+			++running;
+
+	// Written aside, then renamed over the status file, so that readers
+	// never see a partial file.
+	std::string tmpname = filename + ".tmp";
+	{
+		std::ofstream out(tmpname.c_str());
+		if (!out.good())
+			return;
+		out.precision(6);
+		out << "wall_time "    << std::chrono::duration<double>(now - started).count() << "\n";
+		out << "cases_total "  << total << "\n";
+		out << "cases_done "   << done << "\n";
+		out << "cases_failed " << (int)cases_failed << "\n";
+		out << "cases_running " << running << "\n";
+		out << "cases_queued " << ((total > done + running) ? total - done - running : 0) << "\n";
+		out << "# worker  state  case  sim_time  t_end  sim_s_per_wall_s  contacts  solver_iterations  steps  s_since_last_step\n";
+
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			WorkerStatus& w = *workers[i];
+			WorkerSample& s = samples[i];
+			long steps = w.steps.load(std::memory_order_relaxed);
+			double sim_time = w.sim_time.load(std::memory_order_relaxed);
+			bool active = w.active;
+
+			if (active && !s.active)
+				s.last_progress = now;	// case just started: stall time counts from here
+			s.active = active;
+
+			// rate over the last period; a new case restarts the step count
+			double dwall = std::chrono::duration<double>(now - s.sampled).count();
+			if (s.steps >= 0 && steps >= s.steps && dwall > 0)
+				s.sim_rate = (sim_time - s.sim_time) / dwall;
+			else
+				s.sim_rate = 0;
+			if (steps != s.steps)
+				s.last_progress = now;
+			s.steps = steps;
+			s.sim_time = sim_time;
+			s.sampled = now;
+
+			double idle = std::chrono::duration<double>(now - s.last_progress).count();
+
+			const char* state = "idle";
+			if (active)
+				state = (idle > stall_timeout) ? "stalled" : "running";
+
+			std::string label = w.GetLabel();
+			out << "worker " << (int)i << " " << state << " "
+				<< (label.empty() ? "-" : label) << " "
+				<< sim_time << " "
+				<< (double)w.t_end << " "
+				<< (active ? s.sim_rate : 0.0) << " "
+				<< (int)w.contacts << " "
+				<< (int)w.solver_iterations << " "
+				<< steps << " "
+				<< (active ? idle : 0.0) << "\n";
+		}
+	}
+#ifdef _WIN32
+	remove(filename.c_str());
+#endif
+	rename(tmpname.c_str(), filename.c_str());
+}
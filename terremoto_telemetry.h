@@ -0,0 +1,125 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef TERREMOTO_TELEMETRY_H
+#define TERREMOTO_TELEMETRY_H
+
+///////////////////////////////////////////////////
+//
+//   Live status of a batch of cases: the workers
+//   publish their progress in atomics after each
+//   step, and a separate thread periodically
+//   rewrites a status file from them.
+//
+///////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+
+/// Progress of one worker, written by the worker and read by the
+/// telemetry thread. Step() only does relaxed atomic stores, so it can
+/// be called at each time step at no measurable cost.
+
+class WorkerStatus
+{
+public:
+	WorkerStatus() : active(false), sim_time(0), t_end(0), contacts(0), solver_iterations(0), steps(0) {}
+
+	void BeginCase(const std::string& mlabel, double mt_end);
+
+	void Step(double msim_time, int mcontacts, int msolver_iterations)
+	{
+		sim_time.store(msim_time, std::memory_order_relaxed);
+		contacts.store(mcontacts, std::memory_order_relaxed);
+		solver_iterations.store(msolver_iterations, std::memory_order_relaxed);
+		steps.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void EndCase() { active = false; }
+
+	std::string GetLabel() const;
+
+	std::atomic<bool>   active;
+	std::atomic<double> sim_time;
+	std::atomic<double> t_end;
+	std::atomic<int>    contacts;
+	std::atomic<int>    solver_iterations;	// of the last step
+	std::atomic<long>   steps;				// since the start of the case
+
+private:
+	mutable std::mutex label_mutex;
+	std::string label;
+};
+
+
+/// Status file of a batch, rewritten every 'period' seconds (atomically:
+/// written aside, then renamed) with the counts of cases done and queued
+/// and, per worker, the case it runs, simulated seconds per wall second,
+/// contacts, solver iterations, and whether it is stalled, that is, it
+/// did not complete a step for more than 'stall_timeout' seconds.
+
+class Telemetry
+{
+public:
+	Telemetry(const std::string& mfilename, int nworkers = 1, double mperiod = 2.0, double mstall_timeout = 60.0);
+
+		/// Stops the telemetry thread, after a last rewrite of the file.
+	~Telemetry();
+
+	WorkerStatus& GetWorker(int i) { return *workers[i]; }
+
+	void SetCasesTotal(int n) { cases_total = n; }
+	void CaseDone(bool ok) { ++cases_done; if (!ok) ++cases_failed; }
+
+private:
+	typedef std::chrono::steady_clock clock;
+
+	// What the telemetry thread remembers of a worker between two writes
+	struct WorkerSample
+	{
+		WorkerSample() : active(false), steps(-1), sim_time(0), sim_rate(0) {}
+		bool   active;
+		long   steps;
+		double sim_time;
+		double sim_rate;
+		clock::time_point sampled;
+		clock::time_point last_progress;
+	};
+
+	void Run();
+	void Write();
+
+	std::string filename;
+	double period;
+	double stall_timeout;
+	clock::time_point started;
+
+	std::vector<WorkerStatus*> workers;
+	std::vector<WorkerSample> samples;	// used by the telemetry thread only
+
+	std::atomic<int> cases_total;
+	std::atomic<int> cases_done;
+	std::atomic<int> cases_failed;
+
+	std::mutex stop_mutex;
+	std::condition_variable stop_cond;
+	bool stop;
+	std::thread writer;
+};
+
+
+#endif